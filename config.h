@@ -43,6 +43,28 @@
 #define LED_WHITE_COLOR_TEMP 3000
 /** GPIO pin for datastream output */
 #define LED_GPIO 2
+/**
+ * Number of strips to drive in parallel on consecutive GPIO pins starting at @ref LED_GPIO
+ *
+ * @ref LED_PIXEL_COUNT is split evenly between the strips, must be in the range [1, 8]
+ */
+#define LED_PARALLEL_STRIP_COUNT 1
+/**
+ * Number of segments in @ref LED_SEGMENTS
+ *
+ * Set to 0 to drive a single strip (or parallel strips) on @ref LED_GPIO
+ */
+#define LED_SEGMENT_COUNT 0
+/**
+ * Physical segments of the strip, each is driven concurrently by its own state machine
+ *
+ * Comma separated list of `{ gpio, pixel_count, is_rgbw, byte_pos_r, byte_pos_g, byte_pos_b, byte_pos_w }`.
+ * Pixel counts must add up to @ref LED_PIXEL_COUNT.
+ *
+ * Example of a 144 pixel RGBW strip split in two halves:
+ * `{ 2, 72, true, 2, 3, 1, 0 }, { 3, 72, true, 2, 3, 1, 0 }`
+ */
+#define LED_SEGMENTS { LED_GPIO, LED_PIXEL_COUNT, LED_IS_RGBW, LED_BYTE_POS_R, LED_BYTE_POS_G, LED_BYTE_POS_B, LED_BYTE_POS_W }
 /** Datastream frequency (800kHz default) */
 #define LED_FREQUENCY 800000
 /** Position of red color component in datastream */
@@ -53,6 +75,12 @@
 #define LED_BYTE_POS_B 1
 /** Position of white color component in datastream */
 #define LED_BYTE_POS_W 0
+/** Minimum low time (in microseconds) for the strip to latch a frame */
+#define LED_RESET_TIME 300
+/** Maximum time (in microseconds) an unchanged frame can go without being pushed again */
+#define LED_FORCED_REFRESH_INTERVAL (1000 * 1000)
+/** Time (in microseconds) between frames while the sunrise is fading in, the main loop sleeps through the rest of the day */
+#define LED_FRAME_INTERVAL (1000 * 1000 / 100)
 
 /******************************************************
  *                     GPS CONFIG                     *
@@ -74,20 +102,83 @@
 #define GPS_PARITY UART_PARITY_NONE
 /** Echo all characters received by GPS UART */
 #define GPS_ECHO false
+/**
+ * Time in microseconds from the moment a fix describes to the module starting to send its output burst
+ *
+ * This is a property of the GPS module, and can be measured by comparing burst arrival with the PPS output
+ */
+#define GPS_NMEA_LATENCY_US 0
+/**
+ * Minimum idle time in microseconds before a '$' for it to be taken as the start of an output burst
+ *
+ * The module sends the sentences of a burst back to back, and the line is idle for the rest of the fix interval
+ */
+#define GPS_BURST_GAP_US (50 * 1000)
+/**
+ * Longest time in microseconds that an output burst takes to arrive
+ *
+ * Worst case for the sentences enabled by gps_set_config() is 4 sentences of 82 bytes (RMC, GGA, GSA, ZDA), 342 ms at 9600 baud.
+ * This leaves the line idle for at least 158 ms of each 500 ms fix interval.
+ * A ZDA sentence arriving later than this after the burst start is not used for arrival timing.
+ */
+#define GPS_BURST_MAX_US (350 * 1000)
+/** Size of the GPS receive ring buffer (Must be a power of two) */
+#define GPS_RX_BUFFER_SIZE 1024
+/**
+ * Use a DMA channel to copy received bytes into the ring buffer instead of the UART RX interrupt
+ *
+ * This has no per byte CPU cost, but the GPS thread has to poll for new data every @ref GPS_RX_DMA_POLL_INTERVAL
+ */
+#define GPS_RX_USE_DMA false
+/** Interval in microseconds between checks for new data when @ref GPS_RX_USE_DMA is set */
+#define GPS_RX_DMA_POLL_INTERVAL 10000
 
 /** GPIO pin for GPS UART transmit @sa GPS_UART_ID */
 #define GPS_UART_TX_PIN 4
 /** GPIO pin for GPS UART receive @sa GPS_UART_ID*/
 #define GPS_UART_RX_PIN 5
 
+/**
+ * Use the 1PPS output of the GPS module to time clock syncs
+ *
+ * Syncs fall back to timing ZDA by the arrival of its output burst when no pulse has been seen for @ref GPS_PPS_TIMEOUT_US (eg. before a fix, or with the pin unconnected)
+ */
+#define GPS_USE_PPS true
+/** Time in microseconds without a pulse after which syncs fall back to sentence arrival timing */
+#define GPS_PPS_TIMEOUT_US (2 * 1000 * 1000)
+/** GPIO pin connected to the 1PPS output of the GPS module */
+#define GPS_PPS_PIN 6
+
+/******************************************************
+ *              CLOCK DISCIPLINE CONFIG               *
+ ******************************************************/
+
+/** Phase errors larger than this many microseconds are rejected as outliers */
+#define CLOCK_STEP_THRESHOLD (100 * 1000)
+/** Number of consecutive outliers after which the clock is stepped instead */
+#define CLOCK_STEP_OUTLIER_COUNT 4
+/** Fraction of the phase error slewed out after each measurement, as a right shift (2: 1/4) */
+#define CLOCK_PHASE_GAIN_SHIFT 2
+/** Maximum rate in ppm that phase errors are slewed out at */
+#define CLOCK_MAX_SLEW_PPM 500
+/** Minimum number of seconds between frequency error estimates (Longer intervals average out more measurement jitter) */
+#define CLOCK_FREQUENCY_INTERVAL 256
+/** Maximum frequency correction in ppm */
+#define CLOCK_MAX_FREQUENCY_PPM 500
+
 /******************************************************
  *                  TIMEZONE CONFIG                   *
  ******************************************************/
 
-/** Timezone offset during daylight savings time */
-#define TIMEZONE_OFFSET_DT timespan_t(0, -8, 0, 0)
-/** Timezone offset during standard time */
-#define TIMEZONE_OFFSET_ST timespan_t(0, -9, 0, 0)
+/**
+ * Timezone rules as a POSIX TZ string @sa timezone_t::parse()
+ *
+ * Examples:
+ * - Alaska: "AKST9AKDT,M3.2.0,M11.1.0"
+ * - Central Europe: "CET-1CEST,M3.5.0,M10.5.0/3"
+ * - Sydney: "AEST-10AEDT,M10.1.0,M4.1.0/3"
+ */
+#define TIMEZONE_RULES "AKST9AKDT,M3.2.0,M11.1.0"
 
 /******************************************************
  *                  WATCHDOG CONFIG                   *
@@ -122,3 +213,8 @@
  * Number of samples to use for average loop times
  */
 #define LOOP_AVERAGE_SAMPLE_COUNT 256
+
+/**
+ * Size of the ring buffer carrying message payloads from core 1 to core 0 (Must be a power of two)
+ */
+#define CORE_MESSAGE_RING_SIZE 1024
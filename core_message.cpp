@@ -0,0 +1,104 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Typed messages from core 1 to core 0 (Implementation)
+ */
+#include "core_message.h"
+
+#include "config.h"
+#include "ring_buffer.h"
+
+#include "pico/multicore.h"
+
+#include <string.h>
+
+/* FIFO word layout: [31:24] Unused, [23:8] Payload size, [7:0] Type */
+#define WORD_TYPE(word) core_message_type_t((word) & 0xFF)
+#define WORD_LEN(word) (((word) >> 8) & 0xFFFF)
+
+static spsc_ring_t<uint8_t, CORE_MESSAGE_RING_SIZE> payload_ring = {};
+
+/** Only written by core 1 */
+static volatile uint32_t posted = 0;
+static volatile uint32_t dropped = 0;
+static volatile uint32_t max_depth = 0;
+
+/** Only written by core 0 */
+static volatile uint32_t received = 0;
+
+bool core_message_post(const core_message_type_t type, const void* payload, const size_t len)
+{
+    hard_assert(len <= CORE_MESSAGE_MAX_PAYLOAD);
+
+    /* Check the FIFO first so that a payload is never queued without its word */
+    if (!multicore_fifo_wready() || !payload_ring.push((const uint8_t*)payload, len))
+    {
+        dropped = dropped + 1;
+        return false;
+    }
+
+    /* Does not block (checked above), and sets an event to wake core 0 */
+    multicore_fifo_push_blocking(type | (len << 8));
+
+    posted = posted + 1;
+    const uint32_t depth = posted - received;
+    if (depth > max_depth)
+        max_depth = depth;
+
+    return true;
+}
+
+bool core_message_receive(core_message_t& msg)
+{
+    if (!multicore_fifo_rvalid())
+        return false;
+
+    const uint32_t word = multicore_fifo_pop_blocking();
+    msg.type = WORD_TYPE(word);
+    msg.len = WORD_LEN(word);
+
+    /* The payload was pushed before the word, so it is all there */
+    const size_t len = payload_ring.pop(msg.payload, msg.len);
+    hard_assert(len == msg.len);
+
+    received = received + 1;
+    return true;
+}
+
+bool core_message_pending() { return multicore_fifo_rvalid(); }
+
+core_message_stats_t core_message_get_stats()
+{
+    core_message_stats_t r;
+    r.posted = posted;
+    r.dropped = dropped;
+    r.received = received;
+    r.max_depth = max_depth;
+    return r;
+}
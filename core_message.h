@@ -0,0 +1,129 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Typed messages from core 1 to core 0
+ *
+ * Each message is announced by a word in the SIO FIFO, and its payload is carried in a shared ring buffer
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "unix_time.h"
+
+/** Maximum payload size of a message */
+#define CORE_MESSAGE_MAX_PAYLOAD 256
+
+enum core_message_type_t : uint8_t
+{
+    /** The clock was synced to GPS */
+    CORE_MESSAGE_TIME_SYNC,
+    /** GPS fix status, mode or satellites used changed */
+    CORE_MESSAGE_FIX_CHANGED,
+    /** GPS firmware release information was received */
+    CORE_MESSAGE_FIRMWARE_INFO,
+};
+
+struct core_message_time_sync_t
+{
+    /** Unix time the clock was synced to */
+    microseconds_t unix_time;
+    /** Phase error of the clock at the sync */
+    microseconds_t phase_error;
+    /** Sync was timed by a PPS pulse */
+    bool pps;
+};
+
+struct core_message_fix_changed_t
+{
+    /** @ref gps_fix_status_t */
+    int32_t fix_status;
+    int32_t fix_mode;
+    int32_t satellites_used;
+};
+
+struct core_message_t
+{
+    core_message_type_t type;
+    /** Payload size */
+    uint16_t len;
+    union
+    {
+        core_message_time_sync_t time_sync;
+        core_message_fix_changed_t fix_changed;
+        /** Release string, build ID, internal use string 1, and internal use string 2, each null terminated */
+        char firmware_info[CORE_MESSAGE_MAX_PAYLOAD];
+        uint8_t payload[CORE_MESSAGE_MAX_PAYLOAD];
+    };
+};
+
+/**
+ * Post a message to core 0 (Core 1 only)
+ *
+ * Never blocks, the message is dropped if the FIFO or payload ring is full
+ *
+ * @param type Message type
+ * @param payload Payload data
+ * @param len Payload size, must not exceed @ref CORE_MESSAGE_MAX_PAYLOAD
+ *
+ * @returns False if the message was dropped
+ */
+bool core_message_post(const core_message_type_t type, const void* payload, const size_t len);
+
+/**
+ * Receive a message from core 1 (Core 0 only)
+ *
+ * Never blocks
+ *
+ * @returns False if there are no messages waiting
+ */
+bool core_message_receive(core_message_t& msg);
+
+/**
+ * Check if a message is waiting to be received (Core 0 only)
+ */
+bool core_message_pending();
+
+struct core_message_stats_t
+{
+    /** Number of messages posted */
+    uint32_t posted;
+    /** Number of messages dropped because the FIFO or payload ring was full */
+    uint32_t dropped;
+    /** Number of messages received */
+    uint32_t received;
+    /** Highest number of messages posted but not yet received */
+    uint32_t max_depth;
+};
+
+/**
+ * Get message counters
+ */
+core_message_stats_t core_message_get_stats();
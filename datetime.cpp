@@ -36,124 +36,51 @@
 #include "hardware/timer.h"
 #include "stdio.h"
 
-#include <sys/time.h>
-#include <time.h>
-
 datetime_t::datetime_t(const int64_t _year, const int64_t _month, const int64_t _day, const int64_t _hour, const int64_t _minute, const int64_t _second,
     const microseconds_t _microsecond)
 {
-    year = _year;
-    month = _month;
-    day = _day;
-    hour = _hour;
-    minute = _minute;
-    second = _second;
-    microsecond = _microsecond;
+    /* The fields are not cached here, since they may be outside of their normal ranges */
+    const microseconds_t days = days_from_civil(_year, _month, _day);
+    _val = days * MICROSECONDS_PER_DAY + _hour * MICROSECONDS_PER_HOUR + _minute * MICROSECONDS_PER_MINUTE + _second * MICROSECONDS_PER_SECOND + _microsecond;
+    _fields_valid = false;
 }
 
-datetime_t::datetime_t(microseconds_t microseconds_since_1970)
+void datetime_t::compute_fields() const
 {
-    const microseconds_t t = microseconds_since_1970;
-    const time_t t_unix = t / MICROSECONDS_PER_SECOND;
-    struct tm broken = {};
-
-    gmtime_r(&t_unix, &broken);
-
-    year = broken.tm_year + 1900;
-    month = broken.tm_mon + 1;
-    day = broken.tm_mday;
-    hour = broken.tm_hour;
-    minute = broken.tm_min;
-    second = broken.tm_sec;
-    microsecond = t % MICROSECONDS_PER_SECOND;
-    if (microsecond < 0)
-        microsecond = MICROSECONDS_PER_SECOND + microsecond;
+    /* Floor division, so that times before 1970 still have positive time of day fields */
+    microseconds_t days = _val / MICROSECONDS_PER_DAY;
+    microseconds_t time_of_day = _val % MICROSECONDS_PER_DAY;
+    if (time_of_day < 0)
+    {
+        time_of_day += MICROSECONDS_PER_DAY;
+        days--;
+    }
+
+    const civil_date_t date = civil_from_days(days);
+    _fields.year = date.year;
+    _fields.month = date.month;
+    _fields.day = date.day;
+
+    /* Everything past here fits in 32 bits */
+    const uint32_t second_of_day = time_of_day / MICROSECONDS_PER_SECOND;
+    _fields.microsecond = time_of_day % MICROSECONDS_PER_SECOND;
+    _fields.hour = second_of_day / 3600;
+    _fields.minute = second_of_day / 60 % 60;
+    _fields.second = second_of_day % 60;
+    _fields_valid = true;
 }
 
 datetime_t datetime_t::get_current_utc() { return datetime_t(get_unix_time()); }
 
-microseconds_t datetime_t::to_microseconds_since_1970() const
-{
-    struct tm broken = {};
-    broken.tm_year = year - 1900;
-    broken.tm_mon = month - 1;
-    broken.tm_mday = day;
-    broken.tm_hour = hour;
-    broken.tm_min = minute;
-    broken.tm_sec = second;
-
-    time_t t = mktime(&broken);
-
-    return microsecond + microseconds_t(t) * MICROSECONDS_PER_SECOND;
-}
-
 char* datetime_t::print_to_buffer(char* buf, size_t buf_size) const
 {
-    snprintf(buf, buf_size, "%04lld-%02lld-%02lld %02lld:%02lld:%02lld.%06lld", year, month, day, hour, minute, second, microsecond);
+    const fields_t& f = get_fields();
+    snprintf(buf, buf_size, "%04ld-%02u-%02u %02u:%02u:%02u.%06lu", f.year, f.month, f.day, f.hour, f.minute, f.second, f.microsecond);
     return buf;
 }
 
 void datetime_t::print_to_stdout(const char* prefix, const char* terminator) const
 {
-    printf("%s%04lld-%02lld-%02lld %02lld:%02lld:%02lld.%06lld%s", prefix, year, month, day, hour, minute, second, microsecond, terminator);
-}
-
-// Python script to generate this table
-// #!/bin/python3
-// import sys
-// from datetime import date
-// s = ""
-// for year in range(2000, 2400):
-//     for day in range(8, 15):
-//         if(date(year, 3, day).weekday() == 6):
-//             s = "".join((s, f"{day:x}"))
-//             break
-//
-// # Dump source
-// with open(sys.modules[__name__].__file__, "r") as fd:
-//     print("// Python script to generate this table")
-//     for i in fd:
-//         print(f"// {i}", end="")
-//
-// # Dump array
-// print("static const uint8_t dst_start_days[] = {")
-// for line  in [s[i:i+16]   for i in range(0, len(s),   16)]:
-//     print("    ", end="")
-//     for c in [line[i:i+2] for i in range(0, len(line), 2)]:
-//         print(f"0x{c}, ", end="")
-//     print()
-// print("};")
-//
-
-/** The idea behind this lookup table comes from https://cs.uwaterloo.ca/~alopez-o/math-faq/node73.html */
-static const uint8_t dst_start_days[] = { 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98,
-    0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed,
-    0xcb, 0x98, 0xed, 0xba, 0x98, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc,
-    0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba,
-    0x98, 0xdc, 0xba, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9,
-    0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e,
-    0xdc, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed,
-    0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e, 0xcb, 0xa9, 0xed, 0xcb, 0x98, 0xed, 0xba, 0x98, 0xdc, 0xba, 0x8e, 0xdc, 0xa9, 0x8e };
-
-datetime_t datetime_t::get_tz_corrected(timespan_t offset_st, timespan_t offset_dt) const
-{
-    uint8_t dst_start_day = dst_start_days[(year % 400) >> 1];
-
-    if ((year & 1) == 0)
-        dst_start_day >>= 4;
-    dst_start_day &= 0xF;
-
-    // In the US, daylight saving time starts on the second Sunday
-    // in March and ends on the first Sunday in November, with the
-    // time changes taking place at 2:00 a.m. local time.
-    // - Retrieved on 2025-12-10 from:
-    //   https://en.wikipedia.org/wiki/Daylight_saving_time_in_the_United_States
-
-    datetime_t gmt_dt_start = datetime_t(year, 3, dst_start_day, 2, 0, 0) - offset_st; // Second sunday of March of GPS.YEAR at 2 am + offset_st
-    datetime_t gmt_dt_end = datetime_t(year, 11, dst_start_day - 7, 2, 0, 0) - offset_dt; // First sunday of November of GPS.YEAR at 2 am + offset_dt
-
-    if (gmt_dt_start <= *this && *this < gmt_dt_end)
-        return *this + offset_dt;
-    else
-        return *this + offset_st;
+    const fields_t& f = get_fields();
+    printf("%s%04ld-%02u-%02u %02u:%02u:%02u.%06lu%s", prefix, f.year, f.month, f.day, f.hour, f.minute, f.second, f.microsecond, terminator);
 }
@@ -42,6 +42,96 @@
 
 #include "unix_time.h"
 
+/**
+ * Proleptic Gregorian calendar date
+ */
+struct civil_date_t
+{
+    int32_t year;
+    uint32_t month; // Range: [1,12]
+    uint32_t day; // Range: [1,last_day_of_month]
+};
+
+/**
+ * Get number of days since 1970-01-01 of a date in the proleptic Gregorian calendar
+ *
+ * Months outside of [1,12] roll over into adjacent years, and days outside of the month roll over into adjacent months.
+ *
+ * Based on the public domain algorithms from http://howardhinnant.github.io/date_algorithms.html
+ */
+constexpr int32_t days_from_civil(int32_t year, int32_t month, const int32_t day)
+{
+    /* Normalize month to [1,12] */
+    year += (month > 0 ? month - 1 : month - 12) / 12;
+    month -= (month > 0 ? month - 1 : month - 12) / 12 * 12;
+
+    /* Years start in March, so that the leap day is the last day of the year */
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t year_of_era = uint32_t(year - era * 400); // [0, 399]
+    const uint32_t day_of_year = (153 * uint32_t(month > 2 ? month - 3 : month + 9) + 2) / 5; // [0, 365]
+    const uint32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year; // [0, 146096]
+    return era * 146097 + int32_t(day_of_era) - 719468 + (day - 1);
+}
+
+/**
+ * Get the date in the proleptic Gregorian calendar of a number of days since 1970-01-01
+ *
+ * Based on the public domain algorithms from http://howardhinnant.github.io/date_algorithms.html
+ */
+constexpr civil_date_t civil_from_days(int32_t days)
+{
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t day_of_era = uint32_t(days - era * 146097); // [0, 146096]
+    const uint32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365; // [0, 399]
+    const uint32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100); // [0, 365]
+    const uint32_t mp = (5 * day_of_year + 2) / 153; // [0, 11]
+
+    civil_date_t r = {};
+    r.day = day_of_year - (153 * mp + 2) / 5 + 1;
+    r.month = mp < 10 ? mp + 3 : mp - 9;
+    r.year = int32_t(year_of_era) + era * 400 + (r.month <= 2);
+    return r;
+}
+
+/**
+ * Get the day of the week of a number of days since 1970-01-01
+ *
+ * @returns Day of the week, Range: [0,6] (0 is Sunday)
+ */
+constexpr uint32_t weekday_from_days(const int32_t days)
+{
+    /* 1970-01-01 was a Thursday */
+    return uint32_t(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+}
+
+/**
+ * Get number of days since 1970-01-01 of the nth occurrence of a weekday in a month
+ *
+ * @param year Year
+ * @param month Month, Range: [1,12]
+ * @param week Occurrence of the weekday, Range: [1,5] (5 is the last occurrence, which may be the 4th)
+ * @param weekday Day of the week, Range: [0,6] (0 is Sunday)
+ */
+constexpr int32_t nth_weekday_of_month(const int32_t year, const int32_t month, const uint32_t week, const uint32_t weekday)
+{
+    const int32_t first = days_from_civil(year, month, 1);
+    const int32_t days = first + int32_t((weekday + 7 - weekday_from_days(first)) % 7 + (week - 1) * 7);
+
+    /* Occurrences that overflow into the next month are brought back a week */
+    return days >= days_from_civil(year, month + 1, 1) ? days - 7 : days;
+}
+
+static_assert(days_from_civil(1970, 1, 1) == 0, "Epoch must be day 0");
+static_assert(days_from_civil(2000, 3, 1) == 11017, "Leap year handling");
+static_assert(civil_from_days(11016).day == 29, "Leap day");
+static_assert(weekday_from_days(-1) == 3 && weekday_from_days(-7) == 4 && weekday_from_days(-8) == 3, "Weekdays before 1970");
+static_assert(nth_weekday_of_month(2025, 3, 2, 0) == days_from_civil(2025, 3, 9), "Second Sunday of March 2025");
+static_assert(nth_weekday_of_month(2025, 11, 1, 0) == days_from_civil(2025, 11, 2), "First Sunday of November 2025");
+static_assert(nth_weekday_of_month(2025, 3, 5, 0) == days_from_civil(2025, 3, 30), "Last Sunday of March 2025");
+static_assert(nth_weekday_of_month(2026, 3, 5, 0) == days_from_civil(2026, 3, 29), "Last Sunday of March 2026");
+
 struct timespan_t
 {
     inline timespan_t(const int64_t days, const int64_t hours, const int64_t minutes, const int64_t seconds, const microseconds_t microseconds = 0)
@@ -73,36 +163,67 @@ private:
     microseconds_t _val;
 };
 
+/**
+ * Point in time, stored as microseconds since 1970
+ *
+ * Comparisons and arithmetic only touch the epoch value, the calendar fields are computed on first access and cached
+ */
 struct datetime_t
 {
     datetime_t(const int64_t _year, const int64_t _month, const int64_t _day, const int64_t _hour = 0, const int64_t _minute = 0, const int64_t _second = 0,
         const microseconds_t _microsecond = 0);
 
-    datetime_t(microseconds_t microseconds_since_1970);
+    inline datetime_t(const microseconds_t microseconds_since_1970)
+        : _val(microseconds_since_1970)
+        , _fields_valid(false)
+    {
+    }
 
-    int64_t year;
-    int64_t month; // Normal range: [1,12]
-    int64_t day; // Normal range: [1,last_day_of_month]
-    int64_t hour; // Normal range: [0,23]
-    int64_t minute; // Normal range: [0,59]
-    int64_t second; // Normal range: [0,59]
-    microseconds_t microsecond; // Normal range: [0,999999]
+    inline int32_t year() const { return get_fields().year; }
+    inline uint32_t month() const { return get_fields().month; } // Range: [1,12]
+    inline uint32_t day() const { return get_fields().day; } // Range: [1,last_day_of_month]
+    inline uint32_t hour() const { return get_fields().hour; } // Range: [0,23]
+    inline uint32_t minute() const { return get_fields().minute; } // Range: [0,59]
+    inline uint32_t second() const { return get_fields().second; } // Range: [0,59]
+    inline uint32_t microsecond() const { return get_fields().microsecond; } // Range: [0,999999]
 
-    inline datetime_t operator+(const timespan_t& b) const { return datetime_t(to_microseconds_since_1970() + b.to_microseconds_since_1970()); };
-    inline datetime_t operator-(const timespan_t& b) const { return datetime_t(to_microseconds_since_1970() - b.to_microseconds_since_1970()); };
-    inline timespan_t operator-(const datetime_t& b) const { return timespan_t(to_microseconds_since_1970() - b.to_microseconds_since_1970()); };
+    /**
+     * Get midnight at the start of the day this datetime falls on
+     */
+    inline datetime_t get_midnight() const
+    {
+        const microseconds_t time_of_day = _val % MICROSECONDS_PER_DAY;
+        return datetime_t(_val - (time_of_day < 0 ? time_of_day + MICROSECONDS_PER_DAY : time_of_day));
+    }
 
-    inline bool operator<(const datetime_t& b) const { return to_microseconds_since_1970() < b.to_microseconds_since_1970(); }
-    inline bool operator>(const datetime_t& b) const { return to_microseconds_since_1970() > b.to_microseconds_since_1970(); }
-    inline bool operator==(const datetime_t& b) const { return to_microseconds_since_1970() == b.to_microseconds_since_1970(); }
-    inline bool operator<=(const datetime_t& b) const { return to_microseconds_since_1970() <= b.to_microseconds_since_1970(); }
-    inline bool operator>=(const datetime_t& b) const { return to_microseconds_since_1970() >= b.to_microseconds_since_1970(); }
-    inline bool operator!=(const datetime_t& b) const { return to_microseconds_since_1970() != b.to_microseconds_since_1970(); }
+    inline datetime_t operator+(const timespan_t& b) const { return datetime_t(_val + b.to_microseconds_since_1970()); };
+    inline datetime_t operator-(const timespan_t& b) const { return datetime_t(_val - b.to_microseconds_since_1970()); };
+    inline timespan_t operator-(const datetime_t& b) const { return timespan_t(_val - b._val); };
+
+    inline datetime_t& operator+=(const timespan_t& b)
+    {
+        _val += b.to_microseconds_since_1970();
+        _fields_valid = false;
+        return *this;
+    }
+    inline datetime_t& operator-=(const timespan_t& b)
+    {
+        _val -= b.to_microseconds_since_1970();
+        _fields_valid = false;
+        return *this;
+    }
+
+    inline bool operator<(const datetime_t& b) const { return _val < b._val; }
+    inline bool operator>(const datetime_t& b) const { return _val > b._val; }
+    inline bool operator==(const datetime_t& b) const { return _val == b._val; }
+    inline bool operator<=(const datetime_t& b) const { return _val <= b._val; }
+    inline bool operator>=(const datetime_t& b) const { return _val >= b._val; }
+    inline bool operator!=(const datetime_t& b) const { return _val != b._val; }
 
     /**
      * Get number of microseconds since 1970
      */
-    microseconds_t to_microseconds_since_1970() const;
+    inline microseconds_t to_microseconds_since_1970() const { return _val; }
 
     /**
      * Prints the time to `buf` with the format "YYYY-MM-DD hh::mm:ss.us\0"
@@ -126,11 +247,31 @@ struct datetime_t
      */
     static datetime_t get_current_utc();
 
+private:
+    struct fields_t
+    {
+        int32_t year;
+        uint8_t month;
+        uint8_t day;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
+        uint32_t microsecond;
+    };
+
     /**
-     * Returns a timezone corrected version of the current datetime object
-     *
-     * @param offset_st Timezone offset for standard time
-     * @param offset_dt Timezone offset under daylight savings conditions
+     * Get calendar fields, computing them from the epoch value if needed
      */
-    datetime_t get_tz_corrected(timespan_t offset_st, timespan_t offset_dt) const;
+    inline const fields_t& get_fields() const
+    {
+        if (!_fields_valid)
+            compute_fields();
+        return _fields;
+    }
+
+    void compute_fields() const;
+
+    microseconds_t _val;
+    mutable bool _fields_valid;
+    mutable fields_t _fields;
 };
@@ -0,0 +1,201 @@
+// ---------------------------------------------------------------- //
+// This file is autogenerated by the script below; do not edit!     //
+// ---------------------------------------------------------------- //
+
+#pragma once
+
+#include <stdint.h>
+
+// #!/bin/python3
+// # Pre-renders the sunrise into keyframes of per-stop RGB colors
+// #
+// # Usage: ./sunrise_keyframes.py > generated/sunrise_keyframes.h
+// import sys
+// import math
+//
+// KEYFRAME_COUNT = 256
+//
+//
+// def tanner_helland(temp):
+//     temp /= 100.0
+//     r = 255.0 if temp <= 66 else 329.698727446 * (temp - 60) ** -0.1332047592
+//     g = 99.4708025861 * math.log(temp) - 161.1195681661 if temp <= 66 else 288.1221695283 * (temp - 60) ** -0.0755148492
+//     if temp >= 66:
+//         b = 255.0
+//     elif temp <= 19:
+//         b = 0.0
+//     else:
+//         b = 138.5177312231 * math.log(temp - 10) - 305.0447927307
+//     return [min(max(c, 0.0), 255.0) for c in (r, g, b)]
+//
+//
+// def keyframe(sunrise_factor):
+//     # Color temperature for the bottom of the strip, the pow() part gives a slower initial rise
+//     temp_bot = 500.0 + sunrise_factor**2.2 * 3500.0
+//     # Color temperature for the top of the strip, the sin^2() part causes the difference between
+//     # top and bottom to increase as sunrise_factor approaches 0.5 and decrease thereafter
+//     temp_top = temp_bot + math.sin(sunrise_factor * math.pi) ** 2 * 300.0
+//     brightness = min(sunrise_factor * 2.0, 1.0)
+//     return [[round(c * brightness * 256) for c in tanner_helland(t)] for t in (temp_bot, temp_top)]
+//
+//
+// keyframes = [keyframe(i / KEYFRAME_COUNT) for i in range(KEYFRAME_COUNT + 1)]
+//
+// print("// ---------------------------------------------------------------- //")
+// print("// This file is autogenerated by the script below; do not edit!     //")
+// print("// ---------------------------------------------------------------- //")
+// print()
+// print("#pragma once")
+// print()
+// print("#include <stdint.h>")
+// print()
+//
+// # Dump source
+// with open(sys.modules[__name__].__file__, "r") as fd:
+//     for i in fd:
+//         print(f"// {i}".rstrip())
+// print()
+//
+// # Dump array
+// print(f"#define SUNRISE_KEYFRAME_COUNT {KEYFRAME_COUNT}")
+// print()
+// print("/** Q8.8 RGB colors of the bottom and top of the strip, for sunrise_factor = index / SUNRISE_KEYFRAME_COUNT */")
+// print("static const uint16_t sunrise_keyframes[SUNRISE_KEYFRAME_COUNT + 1][2][3] = {")
+// for line in [keyframes[i:i+2] for i in range(0, len(keyframes), 2)]:
+//     print("    " + " ".join("{ " + ", ".join("{ " + ", ".join(str(c) for c in stop) + " }" for stop in k) + " }," for k in line))
+// print("};")
+
+#define SUNRISE_KEYFRAME_COUNT 256
+
+/** Q8.8 RGB colors of the bottom and top of the strip, for sunrise_factor = index / SUNRISE_KEYFRAME_COUNT */
+static const uint16_t sunrise_keyframes[SUNRISE_KEYFRAME_COUNT + 1][2][3] = {
+    { { 0, 0, 0 }, { 0, 0, 0 } }, { { 510, 0, 0 }, { 510, 0, 0 } },
+    { { 1020, 0, 0 }, { 1020, 0, 0 } }, { { 1530, 0, 0 }, { 1530, 0, 0 } },
+    { { 2040, 0, 0 }, { 2040, 0, 0 } }, { { 2550, 0, 0 }, { 2550, 0, 0 } },
+    { { 3060, 0, 0 }, { 3060, 0, 0 } }, { { 3570, 0, 0 }, { 3570, 0, 0 } },
+    { { 4080, 0, 0 }, { 4080, 0, 0 } }, { { 4590, 0, 0 }, { 4590, 2, 0 } },
+    { { 5100, 0, 0 }, { 5100, 8, 0 } }, { { 5610, 0, 0 }, { 5610, 16, 0 } },
+    { { 6120, 0, 0 }, { 6120, 26, 0 } }, { { 6630, 0, 0 }, { 6630, 37, 0 } },
+    { { 7140, 4, 0 }, { 7140, 52, 0 } }, { { 7650, 10, 0 }, { 7650, 68, 0 } },
+    { { 8160, 17, 0 }, { 8160, 87, 0 } }, { { 8670, 25, 0 }, { 8670, 110, 0 } },
+    { { 9180, 35, 0 }, { 9180, 135, 0 } }, { { 9690, 47, 0 }, { 9690, 163, 0 } },
+    { { 10200, 60, 0 }, { 10200, 195, 0 } }, { { 10710, 75, 0 }, { 10710, 230, 0 } },
+    { { 11220, 91, 0 }, { 11220, 269, 0 } }, { { 11730, 110, 0 }, { 11730, 311, 0 } },
+    { { 12240, 130, 0 }, { 12240, 357, 0 } }, { { 12750, 153, 0 }, { 12750, 407, 0 } },
+    { { 13260, 178, 0 }, { 13260, 462, 0 } }, { { 13770, 205, 0 }, { 13770, 520, 0 } },
+    { { 14280, 234, 0 }, { 14280, 583, 0 } }, { { 14790, 266, 0 }, { 14790, 650, 0 } },
+    { { 15300, 301, 0 }, { 15300, 722, 0 } }, { { 15810, 338, 0 }, { 15810, 798, 0 } },
+    { { 16320, 378, 0 }, { 16320, 879, 0 } }, { { 16830, 420, 0 }, { 16830, 965, 0 } },
+    { { 17340, 466, 0 }, { 17340, 1055, 0 } }, { { 17850, 515, 0 }, { 17850, 1151, 0 } },
+    { { 18360, 566, 0 }, { 18360, 1251, 0 } }, { { 18870, 621, 0 }, { 18870, 1356, 0 } },
+    { { 19380, 679, 0 }, { 19380, 1466, 0 } }, { { 19890, 740, 0 }, { 19890, 1581, 0 } },
+    { { 20400, 805, 0 }, { 20400, 1701, 0 } }, { { 20910, 873, 0 }, { 20910, 1827, 0 } },
+    { { 21420, 944, 0 }, { 21420, 1957, 0 } }, { { 21930, 1019, 0 }, { 21930, 2092, 0 } },
+    { { 22440, 1098, 0 }, { 22440, 2233, 0 } }, { { 22950, 1180, 0 }, { 22950, 2379, 0 } },
+    { { 23460, 1266, 0 }, { 23460, 2529, 0 } }, { { 23970, 1356, 0 }, { 23970, 2685, 0 } },
+    { { 24480, 1450, 0 }, { 24480, 2847, 0 } }, { { 24990, 1548, 0 }, { 24990, 3013, 0 } },
+    { { 25500, 1649, 0 }, { 25500, 3184, 0 } }, { { 26010, 1755, 0 }, { 26010, 3360, 0 } },
+    { { 26520, 1865, 0 }, { 26520, 3542, 0 } }, { { 27030, 1979, 0 }, { 27030, 3728, 0 } },
+    { { 27540, 2097, 0 }, { 27540, 3920, 0 } }, { { 28050, 2219, 0 }, { 28050, 4116, 0 } },
+    { { 28560, 2346, 0 }, { 28560, 4317, 0 } }, { { 29070, 2476, 0 }, { 29070, 4524, 0 } },
+    { { 29580, 2611, 0 }, { 29580, 4735, 0 } }, { { 30090, 2751, 0 }, { 30090, 4951, 0 } },
+    { { 30600, 2895, 0 }, { 30600, 5171, 0 } }, { { 31110, 3043, 0 }, { 31110, 5397, 0 } },
+    { { 31620, 3196, 0 }, { 31620, 5627, 0 } }, { { 32130, 3353, 0 }, { 32130, 5862, 0 } },
+    { { 32640, 3514, 0 }, { 32640, 6101, 0 } }, { { 33150, 3681, 0 }, { 33150, 6345, 0 } },
+    { { 33660, 3851, 0 }, { 33660, 6594, 0 } }, { { 34170, 4027, 0 }, { 34170, 6847, 0 } },
+    { { 34680, 4206, 0 }, { 34680, 7104, 0 } }, { { 35190, 4391, 0 }, { 35190, 7366, 0 } },
+    { { 35700, 4580, 0 }, { 35700, 7632, 0 } }, { { 36210, 4773, 0 }, { 36210, 7902, 0 } },
+    { { 36720, 4972, 0 }, { 36720, 8177, 0 } }, { { 37230, 5175, 0 }, { 37230, 8456, 0 } },
+    { { 37740, 5382, 0 }, { 37740, 8738, 0 } }, { { 38250, 5594, 0 }, { 38250, 9025, 0 } },
+    { { 38760, 5811, 0 }, { 38760, 9316, 0 } }, { { 39270, 6033, 0 }, { 39270, 9610, 0 } },
+    { { 39780, 6259, 0 }, { 39780, 9909, 0 } }, { { 40290, 6490, 0 }, { 40290, 10211, 0 } },
+    { { 40800, 6725, 0 }, { 40800, 10517, 0 } }, { { 41310, 6965, 0 }, { 41310, 10827, 0 } },
+    { { 41820, 7210, 0 }, { 41820, 11141, 0 } }, { { 42330, 7460, 0 }, { 42330, 11458, 0 } },
+    { { 42840, 7714, 0 }, { 42840, 11778, 0 } }, { { 43350, 7973, 0 }, { 43350, 12103, 0 } },
+    { { 43860, 8236, 0 }, { 43860, 12430, 0 } }, { { 44370, 8504, 0 }, { 44370, 12761, 0 } },
+    { { 44880, 8777, 0 }, { 44880, 13096, 0 } }, { { 45390, 9054, 0 }, { 45390, 13433, 0 } },
+    { { 45900, 9336, 0 }, { 45900, 13774, 0 } }, { { 46410, 9623, 0 }, { 46410, 14118, 0 } },
+    { { 46920, 9914, 0 }, { 46920, 14465, 0 } }, { { 47430, 10210, 0 }, { 47430, 14816, 0 } },
+    { { 47940, 10510, 0 }, { 47940, 15169, 0 } }, { { 48450, 10815, 0 }, { 48450, 15526, 0 } },
+    { { 48960, 11124, 0 }, { 48960, 15885, 0 } }, { { 49470, 11438, 0 }, { 49470, 16247, 0 } },
+    { { 49980, 11756, 0 }, { 49980, 16612, 0 } }, { { 50490, 12079, 0 }, { 50490, 16980, 0 } },
+    { { 51000, 12407, 0 }, { 51000, 17351, 0 } }, { { 51510, 12738, 0 }, { 51510, 17725, 0 } },
+    { { 52020, 13075, 0 }, { 52020, 18101, 0 } }, { { 52530, 13415, 0 }, { 52530, 18480, 0 } },
+    { { 53040, 13760, 0 }, { 53040, 18862, 0 } }, { { 53550, 14110, 0 }, { 53550, 19246, 0 } },
+    { { 54060, 14463, 0 }, { 54060, 19633, 0 } }, { { 54570, 14822, 0 }, { 54570, 20022, 0 } },
+    { { 55080, 15184, 0 }, { 55080, 20414, 0 } }, { { 55590, 15551, 0 }, { 55590, 20809, 0 } },
+    { { 56100, 15922, 0 }, { 56100, 21206, 0 } }, { { 56610, 16297, 0 }, { 56610, 21605, 0 } },
+    { { 57120, 16677, 0 }, { 57120, 22007, 0 } }, { { 57630, 17060, 0 }, { 57630, 22411, 0 } },
+    { { 58140, 17448, 0 }, { 58140, 22817, 0 } }, { { 58650, 17840, 0 }, { 58650, 23226, 0 } },
+    { { 59160, 18237, 0 }, { 59160, 23637, 0 } }, { { 59670, 18637, 0 }, { 59670, 24050, 0 } },
+    { { 60180, 19041, 0 }, { 60180, 24465, 0 } }, { { 60690, 19450, 0 }, { 60690, 24883, 0 } },
+    { { 61200, 19863, 0 }, { 61200, 25303, 0 } }, { { 61710, 20279, 0 }, { 61710, 25725, 0 } },
+    { { 62220, 20700, 0 }, { 62220, 26149, 0 } }, { { 62730, 21125, 0 }, { 62730, 26576, 0 } },
+    { { 63240, 21554, 0 }, { 63240, 27004, 0 } }, { { 63750, 21986, 0 }, { 63750, 27435, 0 } },
+    { { 64260, 22423, 0 }, { 64260, 27868, 0 } }, { { 64770, 22863, 0 }, { 64770, 28303, 0 } },
+    { { 65280, 23308, 0 }, { 65280, 28740, 0 } }, { { 65280, 23572, 0 }, { 65280, 28952, 0 } },
+    { { 65280, 23836, 0 }, { 65280, 29164, 0 } }, { { 65280, 24099, 0 }, { 65280, 29374, 0 } },
+    { { 65280, 24362, 0 }, { 65280, 29584, 0 } }, { { 65280, 24625, 0 }, { 65280, 29792, 0 } },
+    { { 65280, 24888, 0 }, { 65280, 29998, 0 } }, { { 65280, 25150, 0 }, { 65280, 30204, 0 } },
+    { { 65280, 25412, 0 }, { 65280, 30409, 0 } }, { { 65280, 25673, 0 }, { 65280, 30612, 0 } },
+    { { 65280, 25934, 0 }, { 65280, 30815, 0 } }, { { 65280, 26195, 0 }, { 65280, 31016, 0 } },
+    { { 65280, 26455, 0 }, { 65280, 31216, 0 } }, { { 65280, 26715, 0 }, { 65280, 31416, 0 } },
+    { { 65280, 26974, 0 }, { 65280, 31614, 0 } }, { { 65280, 27233, 0 }, { 65280, 31812, 0 } },
+    { { 65280, 27492, 0 }, { 65280, 32008, 0 } }, { { 65280, 27750, 0 }, { 65280, 32204, 0 } },
+    { { 65280, 28007, 0 }, { 65280, 32399, 0 } }, { { 65280, 28264, 0 }, { 65280, 32592, 0 } },
+    { { 65280, 28521, 0 }, { 65280, 32785, 0 } }, { { 65280, 28777, 0 }, { 65280, 32978, 0 } },
+    { { 65280, 29032, 0 }, { 65280, 33169, 0 } }, { { 65280, 29287, 0 }, { 65280, 33360, 0 } },
+    { { 65280, 29542, 0 }, { 65280, 33550, 0 } }, { { 65280, 29796, 0 }, { 65280, 33739, 0 } },
+    { { 65280, 30049, 0 }, { 65280, 33928, 395 } }, { { 65280, 30302, 0 }, { 65280, 34115, 941 } },
+    { { 65280, 30555, 0 }, { 65280, 34303, 1480 } }, { { 65280, 30806, 0 }, { 65280, 34489, 2014 } },
+    { { 65280, 31057, 0 }, { 65280, 34675, 2541 } }, { { 65280, 31308, 0 }, { 65280, 34861, 3064 } },
+    { { 65280, 31558, 0 }, { 65280, 35046, 3580 } }, { { 65280, 31808, 0 }, { 65280, 35230, 4092 } },
+    { { 65280, 32057, 0 }, { 65280, 35414, 4599 } }, { { 65280, 32305, 0 }, { 65280, 35598, 5101 } },
+    { { 65280, 32553, 0 }, { 65280, 35781, 5598 } }, { { 65280, 32800, 0 }, { 65280, 35963, 6090 } },
+    { { 65280, 33046, 0 }, { 65280, 36145, 6579 } }, { { 65280, 33292, 0 }, { 65280, 36327, 7063 } },
+    { { 65280, 33538, 0 }, { 65280, 36509, 7543 } }, { { 65280, 33782, 0 }, { 65280, 36690, 8019 } },
+    { { 65280, 34027, 683 }, { 65280, 36871, 8491 } }, { { 65280, 34270, 1386 }, { 65280, 37051, 8960 } },
+    { { 65280, 34513, 2081 }, { 65280, 37231, 9425 } }, { { 65280, 34755, 2767 }, { 65280, 37411, 9886 } },
+    { { 65280, 34997, 3444 }, { 65280, 37591, 10345 } }, { { 65280, 35238, 4113 }, { 65280, 37770, 10800 } },
+    { { 65280, 35478, 4774 }, { 65280, 37950, 11252 } }, { { 65280, 35718, 5428 }, { 65280, 38129, 11701 } },
+    { { 65280, 35957, 6074 }, { 65280, 38308, 12147 } }, { { 65280, 36196, 6713 }, { 65280, 38487, 12591 } },
+    { { 65280, 36434, 7345 }, { 65280, 38666, 13031 } }, { { 65280, 36671, 7969 }, { 65280, 38844, 13470 } },
+    { { 65280, 36908, 8587 }, { 65280, 39023, 13905 } }, { { 65280, 37143, 9199 }, { 65280, 39202, 14339 } },
+    { { 65280, 37379, 9804 }, { 65280, 39380, 14769 } }, { { 65280, 37614, 10402 }, { 65280, 39559, 15198 } },
+    { { 65280, 37848, 10995 }, { 65280, 39737, 15625 } }, { { 65280, 38081, 11581 }, { 65280, 39916, 16049 } },
+    { { 65280, 38314, 12162 }, { 65280, 40094, 16471 } }, { { 65280, 38546, 12737 }, { 65280, 40273, 16892 } },
+    { { 65280, 38778, 13306 }, { 65280, 40451, 17310 } }, { { 65280, 39008, 13870 }, { 65280, 40630, 17727 } },
+    { { 65280, 39239, 14428 }, { 65280, 40809, 18142 } }, { { 65280, 39468, 14982 }, { 65280, 40988, 18555 } },
+    { { 65280, 39697, 15530 }, { 65280, 41167, 18967 } }, { { 65280, 39926, 16073 }, { 65280, 41346, 19377 } },
+    { { 65280, 40153, 16611 }, { 65280, 41525, 19785 } }, { { 65280, 40380, 17144 }, { 65280, 41704, 20192 } },
+    { { 65280, 40607, 17673 }, { 65280, 41884, 20597 } }, { { 65280, 40833, 18197 }, { 65280, 42063, 21002 } },
+    { { 65280, 41058, 18717 }, { 65280, 42243, 21404 } }, { { 65280, 41282, 19232 }, { 65280, 42423, 21806 } },
+    { { 65280, 41506, 19742 }, { 65280, 42604, 22206 } }, { { 65280, 41729, 20249 }, { 65280, 42784, 22605 } },
+    { { 65280, 41952, 20751 }, { 65280, 42965, 23003 } }, { { 65280, 42174, 21249 }, { 65280, 43146, 23399 } },
+    { { 65280, 42395, 21743 }, { 65280, 43327, 23795 } }, { { 65280, 42616, 22233 }, { 65280, 43508, 24189 } },
+    { { 65280, 42836, 22720 }, { 65280, 43690, 24583 } }, { { 65280, 43055, 23202 }, { 65280, 43871, 24975 } },
+    { { 65280, 43274, 23681 }, { 65280, 44053, 25366 } }, { { 65280, 43492, 24156 }, { 65280, 44236, 25757 } },
+    { { 65280, 43710, 24627 }, { 65280, 44418, 26146 } }, { { 65280, 43927, 25095 }, { 65280, 44601, 26535 } },
+    { { 65280, 44143, 25559 }, { 65280, 44784, 26922 } }, { { 65280, 44359, 26020 }, { 65280, 44968, 27309 } },
+    { { 65280, 44574, 26477 }, { 65280, 45151, 27695 } }, { { 65280, 44789, 26932 }, { 65280, 45335, 28080 } },
+    { { 65280, 45002, 27382 }, { 65280, 45519, 28464 } }, { { 65280, 45216, 27830 }, { 65280, 45704, 28848 } },
+    { { 65280, 45428, 28275 }, { 65280, 45888, 29230 } }, { { 65280, 45640, 28716 }, { 65280, 46073, 29612 } },
+    { { 65280, 45852, 29154 }, { 65280, 46259, 29993 } }, { { 65280, 46062, 29589 }, { 65280, 46444, 30373 } },
+    { { 65280, 46273, 30022 }, { 65280, 46630, 30753 } }, { { 65280, 46482, 30451 }, { 65280, 46816, 31132 } },
+    { { 65280, 46691, 30878 }, { 65280, 47002, 31510 } }, { { 65280, 46900, 31301 }, { 65280, 47189, 31887 } },
+    { { 65280, 47107, 31722 }, { 65280, 47376, 32264 } }, { { 65280, 47314, 32140 }, { 65280, 47563, 32640 } },
+    { { 65280, 47521, 32556 }, { 65280, 47750, 33015 } }, { { 65280, 47727, 32968 }, { 65280, 47938, 33389 } },
+    { { 65280, 47932, 33379 }, { 65280, 48126, 33763 } }, { { 65280, 48137, 33786 }, { 65280, 48314, 34136 } },
+    { { 65280, 48341, 34191 }, { 65280, 48502, 34509 } }, { { 65280, 48545, 34593 }, { 65280, 48691, 34880 } },
+    { { 65280, 48748, 34993 }, { 65280, 48879, 35251 } }, { { 65280, 48951, 35391 }, { 65280, 49068, 35621 } },
+    { { 65280, 49152, 35786 }, { 65280, 49258, 35991 } }, { { 65280, 49354, 36178 }, { 65280, 49447, 36360 } },
+    { { 65280, 49554, 36569 }, { 65280, 49636, 36728 } }, { { 65280, 49755, 36957 }, { 65280, 49826, 37095 } },
+    { { 65280, 49954, 37342 }, { 65280, 50016, 37462 } }, { { 65280, 50153, 37726 }, { 65280, 50206, 37828 } },
+    { { 65280, 50352, 38107 }, { 65280, 50397, 38193 } }, { { 65280, 50549, 38486 }, { 65280, 50587, 38558 } },
+    { { 65280, 50747, 38863 }, { 65280, 50778, 38922 } }, { { 65280, 50943, 39237 }, { 65280, 50968, 39285 } },
+    { { 65280, 51140, 39610 }, { 65280, 51159, 39647 } }, { { 65280, 51335, 39980 }, { 65280, 51350, 40008 } },
+    { { 65280, 51530, 40349 }, { 65280, 51541, 40369 } }, { { 65280, 51725, 40715 }, { 65280, 51732, 40729 } },
+    { { 65280, 51919, 41079 }, { 65280, 51923, 41088 } }, { { 65280, 52112, 41442 }, { 65280, 52115, 41447 } },
+    { { 65280, 52305, 41802 }, { 65280, 52306, 41804 } }, { { 65280, 52497, 42160 }, { 65280, 52497, 42161 } },
+    { { 65280, 52689, 42517 }, { 65280, 52689, 42517 } },
+};
@@ -32,7 +32,11 @@
 
 #include "gps.h"
 
+#include "core_message.h"
 #include "datetime.h"
+#include "gps_pps.h"
+#include "gps_rx.h"
+#include "seqlock.h"
 
 #include "hardware/uart.h"
 #include "pico/stdlib.h"
@@ -42,23 +46,63 @@
 
 #define arraysizeof(array) (sizeof(array) / sizeof(array[0]))
 
-gps_data_t gps_data = {};
-
-static void gps_handle_character(const uint8_t c);
-
 /**
- * Version of uart_write_blocking() that switches to reading and then handling characters only when the TX FIFO is full
+ * GPS module internal data
+ *
+ * Only touched by the GPS thread, other threads read the published copies through gps_update_snapshot()
+ *
+ * Struct must be zero-initialized
  */
-static void gps_uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len)
+struct gps_data_t
 {
-    for (size_t i = 0; i < len; ++i)
-    {
-        while (!uart_is_writable(uart))
-            if (uart_is_readable(uart))
-                gps_handle_character(uart_getc(uart));
-        uart_get_hw(uart)->dr = *src++;
-    }
-}
+    gps_fix_t fix;
+    gps_firmware_t firmware;
+    gps_stats_t stats;
+
+    /** Time to reach before gps_loop() will call gps_set_config() */
+    absolute_time_t next_config_sync;
+
+    /** Sentence buffers, one is filled while the other holds the last fully received sentence */
+    char nmea_buffers[2][NMEA_BUFFER_SIZE];
+    int nmea_in_progress_idx; /**< Index of the buffer holding `nmea_in_progress()` */
+
+    size_t nmea_last_full_len; /**< Length of `nmea_last_full()` */
+    size_t nmea_in_progress_len; /**< Length of `nmea_in_progress()` */
+
+    /** Last fully received sentence */
+    const char* nmea_last_full() const { return nmea_buffers[nmea_in_progress_idx ^ 1]; }
+    /** Sentence currently being received, may be empty */
+    char* nmea_in_progress() { return nmea_buffers[nmea_in_progress_idx]; }
+
+    loop_measure_t perf;
+};
+
+static gps_data_t gps_data = {};
+
+static seqlock_t<gps_fix_t> published_fix = {};
+static seqlock_t<gps_firmware_t> published_firmware = {};
+static seqlock_t<gps_stats_t> published_stats = {};
+static seqlock_t<gps_nmea_t> published_nmea = {};
+static seqlock_t<absolute_time_t> published_watchdog_expiry_time = {};
+
+/** Copy of `gps_data.fix` as last published */
+static gps_fix_t last_published_fix = {};
+/** Value of `gps_data.stats.parser.sentences` when `published_nmea` was last written */
+static uint32_t last_published_sentence = 0;
+
+/** Estimated `time_us_64()` value at which the current sentence started arriving */
+static uint64_t sentence_start_time = 0;
+
+/** Estimated `time_us_64()` value at which the current output burst started arriving */
+static uint64_t burst_start_time = 0;
+/** Set when a burst starts, cleared once its first sentence is complete */
+static bool burst_first_sentence = false;
+/** The current burst started with fix output, so `burst_start_time` can be used to time a sync */
+static bool burst_valid = false;
+/** Estimated `time_us_64()` value at which the last byte handed to the parser finished arriving */
+static uint64_t last_byte_time = 0;
+
+static void gps_handle_character(const uint8_t c);
 
 /**
  * Send a NMEA message to the GPS module
@@ -83,15 +127,8 @@ static void gps_write_nmea(const char* fmt, ...)
         checksum = checksum ^ buf[i];
     snprintf(buf + strlen(buf), BUF_SIZE - strlen(buf), "*%02X\r\n", checksum);
 
-    /* Flush any data from the RX buffer now */
-    while (uart_is_readable(GPS_UART_ID))
-        gps_handle_character(uart_getc(GPS_UART_ID));
-
-    gps_uart_write_blocking(GPS_UART_ID, (uint8_t*)buf, strlen(buf));
-
-    /* Flush any data from the RX buffer now */
-    while (uart_is_readable(GPS_UART_ID))
-        gps_handle_character(uart_getc(GPS_UART_ID));
+    /* Received characters are queued by the RX interrupt, so blocking on the TX FIFO is fine */
+    uart_write_blocking(GPS_UART_ID, (uint8_t*)buf, strlen(buf));
 
     free(buf);
 }
@@ -101,8 +138,12 @@ void gps_set_config()
     /* Set update frequency to 2Hz */
     gps_write_nmea("PMTK220,500");
 
-    /* Disable all NMEA sentences except NMEA_SEN_GGA (GPS Fix Data) and NMEA_SEN_ZDA (Time & Date) */
-    gps_write_nmea("PMTK314,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0");
+    /* Enable NMEA_SEN_RMC (Recommended Minimum), NMEA_SEN_GGA (GPS Fix Data), NMEA_SEN_GSA (DOP and Active Satellites), and NMEA_SEN_ZDA (Time & Date)
+     * every fix, disable everything else
+     *
+     * NMEA_SEN_GSV (Satellites in View) stays off, with a full sky it is 4 sentences on its own,
+     * which would stretch the burst past the 500 ms fix interval at 9600 baud (See @ref GPS_BURST_MAX_US) */
+    gps_write_nmea("PMTK314,0,1,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,0");
 
     /* Query release information */
     gps_write_nmea("PMTK605");
@@ -117,17 +158,22 @@ void gps_init()
     uart_set_hw_flow(GPS_UART_ID, false, false);
     uart_set_translate_crlf(GPS_UART_ID, 0);
 
+    gps_rx_init();
+
+    if (GPS_USE_PPS)
+        gps_pps_init();
+
     /* Set update frequency to 1Hz */
     gps_write_nmea("PMTK220,500");
 
     /* Wait for GPS to send something */
-    while (!uart_is_readable(GPS_UART_ID))
+    while (!gps_rx_available())
     {
         printf("Waiting for GPS to become readable!\n");
         sleep_ms(50);
     }
 
-    gps_data.fix_status = GPS_NO_FIX;
+    gps_data.fix.fix_status = GPS_NO_FIX;
 
     gps_data.next_config_sync = from_us_since_boot(0);
 
@@ -135,151 +181,556 @@ void gps_init()
 }
 
 /**
- * Check if a NMEA sentence is valid
+ * Parsed NMEA sentence, fields are not null terminated
+ */
+struct nmea_sentence_t
+{
+    const char* data;
+    int argc;
+    const uint16_t* field_start;
+    const uint16_t* field_len;
+};
+
+/**
+ * Pack up to 8 characters of a sentence ID into an integer, so that IDs can be used as switch labels
+ */
+constexpr uint64_t nmea_pack_id(const char* str, const size_t len) { return len == 0 ? 0 : (nmea_pack_id(str, len - 1) << 8) | uint8_t(str[len - 1]); }
+
+constexpr uint64_t operator"" _nmea(const char* str, const size_t len) { return nmea_pack_id(str, len); }
+
+/**
+ * Get the packed ID of a sentence
+ *
+ * The talker is stripped from standard sentences, so that "GPGGA" and "GNGGA" are both "GGA"_nmea
+ *
+ * @returns Packed ID, or 0 if the ID is too long
+ */
+static uint64_t sentence_id(const nmea_sentence_t& s)
+{
+    const char* const id = s.data + s.field_start[0];
+    const size_t len = s.field_len[0];
+
+    if (len == 5 && id[0] != 'P')
+        return nmea_pack_id(id + 2, 3);
+
+    if (len > 8)
+        return 0;
+
+    return nmea_pack_id(id, len);
+}
+
+/**
+ * Copy a field to a null terminated string, truncating if necessary
+ */
+static void field_copy(const nmea_sentence_t& s, const int i, char* dst, const size_t dst_size)
+{
+    size_t len = s.field_len[i];
+    if (len > dst_size - 1)
+        len = dst_size - 1;
+    memcpy(dst, s.data + s.field_start[i], len);
+    dst[len] = '\0';
+}
+
+/** Maximum number of significant digits in a scaled decimal field, so that it always fits in an int64_t */
+#define NMEA_DECIMAL_MAX_DIGITS 18
+
+/**
+ * Decode a decimal number into fixed point
+ *
+ * Excess fractional digits are truncated
+ *
+ * @param frac_digits Number of fractional digits in the output, the output is scaled by 10^frac_digits
+ * @param allow_sign Accept a leading '+' or '-'
+ *
+ * @returns False if the field is empty or malformed
+ */
+static bool field_decimal(const nmea_sentence_t& s, const int i, const int frac_digits, const bool allow_sign, int64_t& out)
+{
+    const char* p = s.data + s.field_start[i];
+    const char* const end = p + s.field_len[i];
+
+    bool negative = false;
+    if (allow_sign && p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    /* Integer digits allowed before the scaled value could overflow */
+    const int max_int_digits = NMEA_DECIMAL_MAX_DIGITS - frac_digits;
+
+    int64_t val = 0;
+    int int_digits = 0;
+    for (; p < end && *p != '.'; p++)
+    {
+        if (*p < '0' || *p > '9' || ++int_digits > max_int_digits)
+            return false;
+        val = val * 10 + (*p - '0');
+    }
+
+    if (p < end)
+        p++;
+
+    int digits = 0;
+    int extra_digits = 0;
+    for (; p < end; p++)
+    {
+        if (*p < '0' || *p > '9')
+            return false;
+        if (digits < frac_digits)
+        {
+            val = val * 10 + (*p - '0');
+            digits++;
+        }
+        else
+            extra_digits++;
+    }
+
+    /* Reject fields without any digits (eg. "." or "-") */
+    if (int_digits + digits + extra_digits == 0)
+        return false;
+
+    for (; digits < frac_digits; digits++)
+        val *= 10;
+
+    out = negative ? -val : val;
+    return true;
+}
+
+/**
+ * Decode an integer field
  *
- * @param sentence Sentence to check (Must be null terminated)
- * @param len Length of sentence (not including null terminator)
+ * @returns False if the field is empty, malformed, or does not fit in an int32_t
  */
-static bool is_valid_nmea_sentence(const char* sentence, size_t len)
+static bool field_int(const nmea_sentence_t& s, const int i, int32_t& out)
 {
-    if (sentence[0] != '$')
+    if (memchr(s.data + s.field_start[i], '.', s.field_len[i]))
         return false;
 
-    /* Minimum message is "$*00\r\n" */
-    if (len < 6)
+    int64_t val;
+    if (!field_decimal(s, i, 0, true, val))
+        return false;
+    if (val > INT32_MAX || val < INT32_MIN)
         return false;
 
-    uint8_t checksum_provided = 0;
-    uint8_t checksum_calculated = 0;
+    out = val;
+    return true;
+}
 
-    if (sscanf(sentence + len - 5, "*%hhX\r\n", &checksum_provided) != 1)
+/**
+ * Decode a decimal field into fixed point
+ *
+ * @param frac_digits Number of fractional digits in the output, the output is scaled by 10^frac_digits
+ *
+ * @returns False if the field is empty, malformed, or does not fit in an int32_t
+ */
+static bool field_fixed(const nmea_sentence_t& s, const int i, const int frac_digits, int32_t& out)
+{
+    int64_t val;
+    if (!field_decimal(s, i, frac_digits, true, val))
+        return false;
+    if (val > INT32_MAX || val < INT32_MIN)
         return false;
 
-    for (size_t i = 1; i < len - 5; i++)
-        checksum_calculated = checksum_calculated ^ sentence[i];
+    out = val;
+    return true;
+}
 
-    if (checksum_calculated != checksum_provided)
+/**
+ * Decode a hhmmss.sss field
+ *
+ * @param out Microseconds since midnight
+ *
+ * @returns False if the field is empty, malformed, or out of range
+ */
+static bool field_time(const nmea_sentence_t& s, const int i, microseconds_t& out)
+{
+    int64_t val;
+    if (s.field_len[i] < 6 || !field_decimal(s, i, 6, false, val))
+        return false;
+
+    const int64_t hhmmss = val / 1000000;
+    const int64_t hour = hhmmss / 10000;
+    const int64_t minute = hhmmss / 100 % 100;
+    const int64_t second = hhmmss % 100;
+
+    /* Allow for leap seconds */
+    if (hour > 23 || minute > 59 || second > 60)
         return false;
 
+    out = hour * MICROSECONDS_PER_HOUR + minute * MICROSECONDS_PER_MINUTE + second * MICROSECONDS_PER_SECOND + val % 1000000;
     return true;
 }
 
-static void end_of_sentence()
+/**
+ * Decode a ddmm.mmmm/dddmm.mmmm field and the hemisphere field following it
+ *
+ * @param out Degrees scaled by 10^7, negative for the south/west hemispheres
+ *
+ * @returns False if either field is empty or malformed
+ */
+static bool field_lat_long(const nmea_sentence_t& s, const int i, int32_t& out)
 {
-    if (!is_valid_nmea_sentence(gps_data.nmea_in_progress, gps_data.nmea_in_progress_len))
+    int64_t val;
+    if (!field_decimal(s, i, 6, false, val) || s.field_len[i + 1] != 1)
+        return false;
+
+    const int64_t degrees = val / 100000000;
+    const int64_t minutes = val % 100000000;
+
+    if (minutes >= 60 * 1000000)
+        return false;
+
+    const int64_t scaled = degrees * 10000000 + minutes / 6;
+    if (scaled > 180 * 10000000)
+        return false;
+
+    /* `out` is only written once both fields are known to be good */
+    switch (s.data[s.field_start[i + 1]])
     {
-        memset(gps_data.nmea_in_progress, 0, sizeof(gps_data.nmea_in_progress));
-        gps_data.nmea_in_progress_len = 0;
-        return;
+    case 'N':
+    case 'E':
+        out = scaled;
+        return true;
+    case 'S':
+    case 'W':
+        out = -scaled;
+        return true;
+    default:
+        return false;
     }
+}
 
-    memcpy(gps_data.nmea_last_full, gps_data.nmea_in_progress, sizeof(gps_data.nmea_in_progress));
-    gps_data.nmea_last_full_len = gps_data.nmea_in_progress_len;
+/**
+ * Get the value of a hex digit
+ *
+ * @returns Value of digit, or -1 if the character is not a hex digit
+ */
+static int hex_digit(const uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
 
-    memset(gps_data.nmea_in_progress, 0, sizeof(gps_data.nmea_in_progress));
-    gps_data.nmea_in_progress_len = 0;
+/** Rising edge time of the last pulse used for a sync, so that ZDA and RMC do not both sync to the same pulse */
+static uint64_t last_synced_pulse = 0;
 
-    char* const field_data = (char*)malloc((gps_data.nmea_last_full_len + 4) * sizeof(char));
-    char** const argv = (char**)malloc((gps_data.nmea_last_full_len + 4) * sizeof(char*));
-    int argc = 0;
+/**
+ * Sync the clock to a time decoded from the current sentence
+ *
+ * While pulses are arriving, only whole seconds paired with the preceding pulse are used.
+ * Arrival timing is only used once no pulse has been seen for @ref GPS_PPS_TIMEOUT_US,
+ * since it jitters by milliseconds and would undo the accuracy of the pulse timed syncs.
+ * It is taken from the start of the output burst rather than from the sentence itself,
+ * as the position of a sentence within the burst moves with the length of the sentences before it.
+ *
+ * @param t Time described by the sentence
+ * @param arrival_timing Sentence can be timed by its arrival (Only one sentence type should be, so that each burst is only used once)
+ */
+static void sync_time(const microseconds_t t, const bool arrival_timing)
+{
+    uint64_t pulse = 0;
+    const bool pulse_recent = GPS_USE_PPS && gps_pps_get_last(pulse) && time_us_64() - pulse < GPS_PPS_TIMEOUT_US;
 
-    for (size_t i = 0; i < gps_data.nmea_last_full_len; i++)
+    if (pulse_recent)
     {
-        switch (gps_data.nmea_last_full[i])
+        /* Fractional seconds (eg. the .500 sentences at 2 Hz), or a pulse that does not directly precede the burst (or the sentence, if the burst start was not seen) */
+        const uint64_t start = burst_valid ? burst_start_time : sentence_start_time;
+        if (t % MICROSECONDS_PER_SECOND != 0 || pulse >= start || start - pulse >= MICROSECONDS_PER_SECOND)
         {
-        case '\r':
-        case '\n':
-            break;
-        case '$':
-        case ',':
-        case '*':
-            field_data[i] = '\0';
-            field_data[i + 1] = '\0';
-            argv[argc++] = field_data + i + 1;
-            break;
-        default:
-            field_data[i] = gps_data.nmea_last_full[i];
-            field_data[i + 1] = '\0';
-            break;
+            gps_data.stats.sync.skipped++;
+            return;
         }
-    }
 
-    if (argc < 1)
-    {
-        free(field_data);
-        free(argv);
-        return;
-    }
+        if (pulse == last_synced_pulse)
+            return;
+        last_synced_pulse = pulse;
 
-    /* GPGGA - GPS Fix Data
-     * 0: ID
-     * 1: UTC Time: hhmmss.sss
-     * 2: Latitude: ddmm.mmmm
-     * 3: Latitude [N: North, S: South]
-     * 4: Longitude: ddmm.mmmm
-     * 5: Longitude: [E: East, W: West]
-     * 6: Fix status: [0: No Fix, 1: Has Fix, 2: Differential GPS Fix]
-     * 7: Satellites Used
-     * 8: Horizontal dilution of precision
-     * 9: Antenna altitude (Mean-sea-level)
-     * 10: Antenna altitude Units (Mean-sea-level)
-     * 11: Geoidal separation
-     * 12: Geoidal separation units
-     * 13: Age of differential correction data (seconds) (Empty if no differential data available)
-     * 14: Differential station ID (Empty if no differential data available)
-     * 15: Checksum
-     */
-    if (strcmp(argv[0], "GPGGA") == 0 && argc == 16)
+        gps_data.stats.sync.residual = sync_unix_time(t, pulse);
+        gps_data.stats.sync.pps_count++;
+    }
+    else if (arrival_timing)
     {
-        gps_data.fix_status = static_cast<gps_fix_status_t>(strtol(argv[6], NULL, 10));
-        gps_data.satellites_used = strtol(argv[7], NULL, 10);
+        /* Either the start of the burst was missed, or it began with something other than fix output (eg. a PMTK001 acknowledgement) */
+        if (!burst_valid || sentence_start_time - burst_start_time >= GPS_BURST_MAX_US)
+        {
+            gps_data.stats.sync.skipped++;
+            return;
+        }
+        gps_data.stats.sync.residual = sync_unix_time(t, burst_start_time - GPS_NMEA_LATENCY_US);
     }
+    else
+        return;
 
-    /* GPZDA - Date & Time
-     * 0: ID
-     * 1: UTC Time: hhmmss.sss
-     * 2: UTC Day
-     * 3: UTC Month
-     * 4: UTC Year
-     * 5: Local zone description (Usually empty)
-     * 6: Local zone minutes description (Usually empty)
-     * 7: Checksum
-     */
-    if (strcmp(argv[0], "GPZDA") == 0 && argc == 8)
-    {
-        datetime_t t = datetime_t(1971, 1, 1);
+    gps_data.stats.sync.parse_delay = time_us_64() - sentence_start_time;
+    gps_data.stats.sync.count++;
+
+    core_message_time_sync_t msg;
+    msg.unix_time = t;
+    msg.phase_error = gps_data.stats.sync.residual;
+    msg.pps = pulse_recent;
+    core_message_post(CORE_MESSAGE_TIME_SYNC, &msg, sizeof(msg));
+}
+
+/* GGA - GPS Fix Data
+ * 0: ID
+ * 1: UTC Time: hhmmss.sss
+ * 2: Latitude: ddmm.mmmm
+ * 3: Latitude [N: North, S: South]
+ * 4: Longitude: ddmm.mmmm
+ * 5: Longitude: [E: East, W: West]
+ * 6: Fix status: [0: No Fix, 1: Has Fix, 2: Differential GPS Fix]
+ * 7: Satellites Used
+ * 8: Horizontal dilution of precision
+ * 9: Antenna altitude (Mean-sea-level)
+ * 10: Antenna altitude Units (Mean-sea-level)
+ * 11: Geoidal separation
+ * 12: Geoidal separation units
+ * 13: Age of differential correction data (seconds) (Empty if no differential data available)
+ * 14: Differential station ID (Empty if no differential data available)
+ */
+static void handle_gga(const nmea_sentence_t& s)
+{
+    if (s.argc != 15)
+        return;
+
+    int32_t fix_status;
+    if (field_int(s, 6, fix_status))
+        gps_data.fix.fix_status = static_cast<gps_fix_status_t>(fix_status);
+    field_int(s, 7, gps_data.fix.satellites_used);
+    field_fixed(s, 8, 2, gps_data.fix.hdop);
+    field_fixed(s, 9, 1, gps_data.fix.altitude);
+    field_lat_long(s, 2, gps_data.fix.latitude);
+    field_lat_long(s, 4, gps_data.fix.longitude);
+}
+
+/* RMC - Recommended Minimum Navigation Information
+ * 0: ID
+ * 1: UTC Time: hhmmss.sss
+ * 2: Status [A: Valid, V: Invalid]
+ * 3: Latitude: ddmm.mmmm
+ * 4: Latitude [N: North, S: South]
+ * 5: Longitude: dddmm.mmmm
+ * 6: Longitude: [E: East, W: West]
+ * 7: Speed over ground (knots)
+ * 8: Course over ground (degrees)
+ * 9: UTC Date: ddmmyy
+ * 10: Magnetic variation (Usually empty)
+ * 11: Magnetic variation direction (Usually empty)
+ * 12: Mode [N: No fix, A: Autonomous, D: Differential, E: Estimated] (NMEA 2.3 and later)
+ */
+static void handle_rmc(const nmea_sentence_t& s)
+{
+    if (s.argc < 12)
+        return;
+
+    gps_data.fix.rmc_valid = s.field_len[2] == 1 && s.data[s.field_start[2]] == 'A';
+    if (!gps_data.fix.rmc_valid)
+        return;
+
+    field_lat_long(s, 3, gps_data.fix.latitude);
+    field_lat_long(s, 5, gps_data.fix.longitude);
+    field_fixed(s, 7, 2, gps_data.fix.speed);
+    field_fixed(s, 8, 2, gps_data.fix.course);
+
+    microseconds_t time_of_day;
+    int32_t ddmmyy;
+    if (s.field_len[9] != 6 || !field_time(s, 1, time_of_day) || !field_int(s, 9, ddmmyy))
+        return;
+
+    /* Only paired with pulses, ZDA is the sentence timed by arrival */
+    sync_time(datetime_t(2000 + ddmmyy % 100, ddmmyy / 100 % 100, ddmmyy / 10000).to_microseconds_since_1970() + time_of_day, false);
+}
+
+/* GSA - DOP and Active Satellites
+ * 0: ID
+ * 1: Mode [M: Manual, A: Automatic]
+ * 2: Fix mode [1: No fix, 2: 2D, 3: 3D]
+ * 3-14: PRNs of satellites used (Empty fields for unused channels)
+ * 15: Position dilution of precision
+ * 16: Horizontal dilution of precision
+ * 17: Vertical dilution of precision
+ */
+static void handle_gsa(const nmea_sentence_t& s)
+{
+    if (s.argc != 18)
+        return;
+
+    field_int(s, 2, gps_data.fix.fix_mode);
+    field_fixed(s, 15, 2, gps_data.fix.pdop);
+    field_fixed(s, 16, 2, gps_data.fix.hdop);
+    field_fixed(s, 17, 2, gps_data.fix.vdop);
+}
+
+/* GSV - Satellites in View
+ * 0: ID
+ * 1: Number of messages in this cycle
+ * 2: Message number
+ * 3: Satellites in view
+ * 4-7, 8-11, 12-15, 16-19: PRN, Elevation (degrees), Azimuth (degrees), SNR (dB-Hz, Empty when not tracking)
+ */
+static void handle_gsv(const nmea_sentence_t& s)
+{
+    if (s.argc < 4)
+        return;
+
+    field_int(s, 3, gps_data.fix.satellites_in_view);
+}
+
+/* ZDA - Date & Time
+ * 0: ID
+ * 1: UTC Time: hhmmss.sss
+ * 2: UTC Day
+ * 3: UTC Month
+ * 4: UTC Year
+ * 5: Local zone description (Usually empty)
+ * 6: Local zone minutes description (Usually empty)
+ */
+static void handle_zda(const nmea_sentence_t& s)
+{
+    if (s.argc != 7)
+        return;
+
+    microseconds_t time_of_day;
+    int32_t day, month, year;
+    if (!field_time(s, 1, time_of_day) || !field_int(s, 2, day) || !field_int(s, 3, month) || !field_int(s, 4, year))
+        return;
 
-        sscanf(argv[1], "%02lld%02lld%02lld.%lld", &t.hour, &t.minute, &t.second, &t.microsecond);
-        t.microsecond *= 1000;
+    sync_time(datetime_t(year, month, day).to_microseconds_since_1970() + time_of_day, true);
+}
+
+/* PMTK001 - Acknowledgement
+ * 0: ID
+ * 1: Command being acknowledged
+ * 2: Flag [0: Invalid command, 1: Unsupported command, 2: Valid command but action failed, 3: Success]
+ */
+static void handle_pmtk001(const nmea_sentence_t& s)
+{
+    if (s.argc != 3)
+        return;
+
+    if (!field_int(s, 1, gps_data.stats.last_ack_command) || !field_int(s, 2, gps_data.stats.last_ack_flag))
+        return;
+
+    if (gps_data.stats.last_ack_flag != 3)
+        gps_data.stats.failed_acks++;
+}
+
+/* PMTK_DT_RELEASE - Firmware release information
+ * 0: ID
+ * 1: Release string
+ * 2: Build ID
+ * 3: Internal use string 1
+ * 4: Internal use string 2
+ */
+static void handle_pmtk705(const nmea_sentence_t& s)
+{
+    if (s.argc != 4 && s.argc != 5)
+        return;
+
+    static gps_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+
+    field_copy(s, 1, firmware.release_str, sizeof(firmware.release_str));
+    field_copy(s, 2, firmware.build_id, sizeof(firmware.build_id));
+    field_copy(s, 3, firmware.internal_1, sizeof(firmware.internal_1));
+    if (s.argc == 5)
+        field_copy(s, 4, firmware.internal_2, sizeof(firmware.internal_2));
+
+    /* This is queried every few seconds, but practically never changes */
+    if (memcmp(&firmware, &gps_data.firmware, sizeof(firmware)) == 0)
+        return;
 
-        t.day = strtol(argv[2], NULL, 10);
-        t.month = strtol(argv[3], NULL, 10);
-        t.year = strtol(argv[4], NULL, 10);
+    gps_data.firmware = firmware;
+    published_firmware.write(gps_data.firmware);
 
-        set_unix_time(t.to_microseconds_since_1970());
+    char msg[CORE_MESSAGE_MAX_PAYLOAD];
+    const int len = snprintf(msg, sizeof(msg), "%s%c%s%c%s%c%s", firmware.release_str, '\0', firmware.build_id, '\0', firmware.internal_1, '\0',
+        firmware.internal_2);
+    if (len >= 0 && size_t(len) < sizeof(msg))
+        core_message_post(CORE_MESSAGE_FIRMWARE_INFO, msg, len + 1);
+}
+
+static void end_of_sentence(const nmea_sentence_t& s)
+{
+    const uint64_t id = sentence_id(s);
+
+    if (burst_first_sentence)
+    {
+        burst_first_sentence = false;
+        burst_valid = id == "GGA"_nmea || id == "RMC"_nmea || id == "GSA"_nmea || id == "GSV"_nmea || id == "ZDA"_nmea;
     }
 
-    /* PMTK_DT_RELEASE - Firmware release information
-     * 0: ID
-     * 1: Release string
-     * 2: Build ID
-     * 3: Internal use string 1
-     * 4: Internal use string 2
-     * 5: Checksum
-     */
-    if (strcmp(argv[0], "PMTK705") == 0 && (argc == 5 || argc == 6))
+    switch (id)
     {
-        strcpy(gps_data.firmware_release_str, argv[1]);
-        strcpy(gps_data.firmware_build_id, argv[2]);
-        strcpy(gps_data.firmware_internal_1, argv[3]);
-        if (argc == 6)
-            strcpy(gps_data.firmware_internal_2, argv[4]);
+    case "GGA"_nmea:
+        handle_gga(s);
+        break;
+    case "RMC"_nmea:
+        handle_rmc(s);
+        break;
+    case "GSA"_nmea:
+        handle_gsa(s);
+        break;
+    case "GSV"_nmea:
+        handle_gsv(s);
+        break;
+    case "ZDA"_nmea:
+        handle_zda(s);
+        break;
+    case "PMTK001"_nmea:
+        handle_pmtk001(s);
+        break;
+    case "PMTK705"_nmea:
+        handle_pmtk705(s);
+        break;
+    default:
+        gps_data.stats.parser.unhandled++;
+        break;
     }
+}
+
+enum nmea_parser_state_t
+{
+    /** Waiting for '$' */
+    NMEA_WAIT_START,
+    /** Receiving fields, folding them into the checksum */
+    NMEA_BODY,
+    /** Receiving first checksum digit */
+    NMEA_CHECKSUM_HI,
+    /** Receiving second checksum digit */
+    NMEA_CHECKSUM_LO,
+    /** Waiting for "\r\n" */
+    NMEA_WAIT_END,
+};
+
+static nmea_parser_state_t parser_state = NMEA_WAIT_START;
+static uint8_t checksum_calculated = 0;
+static uint8_t checksum_provided = 0;
+static int field_count = 0;
+static uint16_t field_start[GPS_NMEA_MAX_FIELDS];
+static uint16_t field_len[GPS_NMEA_MAX_FIELDS];
 
-    free(field_data);
-    free(argv);
+/**
+ * End the field in progress at the current character
+ */
+static void end_field() { field_len[field_count - 1] = gps_data.nmea_in_progress_len - 1 - field_start[field_count - 1]; }
+
+/**
+ * End the field in progress and start a new one after the current character
+ *
+ * @returns False if there are too many fields
+ */
+static bool next_field()
+{
+    end_field();
+    if (field_count == GPS_NMEA_MAX_FIELDS)
+        return false;
+    field_start[field_count++] = gps_data.nmea_in_progress_len;
+    return true;
 }
-#undef SENTENCE_ID_IS
 
 /**
  * Handle a received character
@@ -289,19 +740,165 @@ static void gps_handle_character(const uint8_t c)
     if (GPS_ECHO)
         stdio_putchar(c);
 
+    gps_data.stats.parser.bytes++;
+
+    /* A start delimiter always begins a new sentence, even if the previous one was cut off */
     if (c == '$')
     {
-        memset(gps_data.nmea_in_progress, 0, sizeof(gps_data.nmea_in_progress));
+        if (parser_state == NMEA_WAIT_END)
+            gps_data.stats.parser.framing_errors++;
+        parser_state = NMEA_BODY;
+        checksum_calculated = 0;
+        field_count = 1;
+        field_start[0] = 1;
+        gps_data.nmea_in_progress_len = 0;
+    }
+
+    if (parser_state == NMEA_WAIT_START)
+        return;
+
+    if (gps_data.nmea_in_progress_len == NMEA_BUFFER_SIZE - 1)
+    {
+        gps_data.stats.parser.overflows++;
+        parser_state = NMEA_WAIT_START;
+        return;
+    }
+
+    gps_data.nmea_in_progress()[gps_data.nmea_in_progress_len++] = c;
+
+    switch (parser_state)
+    {
+    case NMEA_BODY:
+        if (c == '$')
+            break;
+        if (c == '*')
+        {
+            end_field();
+            parser_state = NMEA_CHECKSUM_HI;
+            break;
+        }
+        checksum_calculated ^= c;
+        if (c == ',' && !next_field())
+        {
+            gps_data.stats.parser.overflows++;
+            parser_state = NMEA_WAIT_START;
+        }
+        break;
+    case NMEA_CHECKSUM_HI:
+    case NMEA_CHECKSUM_LO:
+    {
+        const int digit = hex_digit(c);
+        if (digit < 0)
+        {
+            gps_data.stats.parser.checksum_errors++;
+            parser_state = NMEA_WAIT_START;
+            break;
+        }
+        if (parser_state == NMEA_CHECKSUM_HI)
+        {
+            checksum_provided = digit << 4;
+            parser_state = NMEA_CHECKSUM_LO;
+            break;
+        }
+        checksum_provided |= digit;
+        if (checksum_provided != checksum_calculated)
+        {
+            gps_data.stats.parser.checksum_errors++;
+            parser_state = NMEA_WAIT_START;
+            break;
+        }
+        parser_state = NMEA_WAIT_END;
+        break;
+    }
+    case NMEA_WAIT_END:
+        if (c == '\r')
+            break;
+        parser_state = NMEA_WAIT_START;
+        if (c != '\n')
+        {
+            gps_data.stats.parser.framing_errors++;
+            break;
+        }
+
+        /* Terminated here since publish() copies the sentence to core 0 as a string (The overflow check leaves room for it) */
+        gps_data.nmea_in_progress()[gps_data.nmea_in_progress_len] = '\0';
+
+        /* Swap buffers instead of copying, the finished sentence stays valid until the next one finishes */
+        gps_data.nmea_last_full_len = gps_data.nmea_in_progress_len;
+        gps_data.nmea_in_progress_idx ^= 1;
         gps_data.nmea_in_progress_len = 0;
+        gps_data.nmea_in_progress()[0] = '\0';
+        gps_data.stats.parser.sentences++;
+
+        {
+            nmea_sentence_t s;
+            s.data = gps_data.nmea_last_full();
+            s.argc = field_count;
+            s.field_start = field_start;
+            s.field_len = field_len;
+            end_of_sentence(s);
+        }
+        break;
+    case NMEA_WAIT_START:
+        break;
     }
+}
 
-    if (gps_data.nmea_in_progress_len < sizeof(gps_data.nmea_in_progress) - 1)
-        gps_data.nmea_in_progress[gps_data.nmea_in_progress_len++] = c;
+/**
+ * Publish the sections of `gps_data` that other threads read
+ */
+static void publish()
+{
+    if (memcmp(&gps_data.fix, &last_published_fix, sizeof(gps_fix_t)) != 0)
+    {
+        if (gps_data.fix.fix_status != last_published_fix.fix_status || gps_data.fix.fix_mode != last_published_fix.fix_mode
+            || gps_data.fix.satellites_used != last_published_fix.satellites_used)
+        {
+            core_message_fix_changed_t msg;
+            msg.fix_status = gps_data.fix.fix_status;
+            msg.fix_mode = gps_data.fix.fix_mode;
+            msg.satellites_used = gps_data.fix.satellites_used;
+            core_message_post(CORE_MESSAGE_FIX_CHANGED, &msg, sizeof(msg));
+        }
+
+        last_published_fix = gps_data.fix;
+        published_fix.write(gps_data.fix);
+    }
+
+    if (gps_data.stats.parser.sentences != last_published_sentence)
+    {
+        last_published_sentence = gps_data.stats.parser.sentences;
 
-    if (c == '\n')
-        end_of_sentence();
+        /* Only copy the used part of the buffer */
+        gps_nmea_t& nmea = published_nmea.write_begin();
+        memcpy(nmea.sentence, gps_data.nmea_last_full(), gps_data.nmea_last_full_len + 1);
+        published_nmea.write_end();
+    }
+
+    gps_data.stats.average_loop_time = gps_data.perf.average_loop_time;
+    gps_data.stats.loops_per_second = gps_data.perf.loops_per_second;
+    published_stats.write(gps_data.stats);
+
+    published_watchdog_expiry_time.write(from_us_since_boot(time_us_64() + WATCHDOG_GPS_TIME * 1000));
+}
+
+void gps_update_snapshot(gps_snapshot_t& snapshot)
+{
+    if (published_fix.get_sequence() != snapshot.fix_version)
+        snapshot.fix_version = published_fix.read(snapshot.fix);
+
+    if (published_firmware.get_sequence() != snapshot.firmware_version)
+        snapshot.firmware_version = published_firmware.read(snapshot.firmware);
+
+    if (published_stats.get_sequence() != snapshot.stats_version)
+        snapshot.stats_version = published_stats.read(snapshot.stats);
+
+    if (published_nmea.get_sequence() != snapshot.nmea_version)
+        snapshot.nmea_version = published_nmea.read(snapshot.nmea_last_full);
 }
 
+absolute_time_t gps_get_watchdog_expiry_time() { return published_watchdog_expiry_time.read(); }
+
 void gps_loop()
 {
     if (time_reached(gps_data.next_config_sync))
@@ -309,11 +906,37 @@ void gps_loop()
         gps_set_config();
         gps_data.next_config_sync = from_us_since_boot(time_us_64() + MICROSECONDS_PER_SECOND * 5);
     }
-    while (uart_is_readable(GPS_UART_ID))
-        gps_handle_character(uart_getc(GPS_UART_ID));
 
-    gps_data.watchdog_expiry_time = from_us_since_boot(time_us_64() + WATCHDOG_GPS_TIME * 1000);
+    uint8_t buf[64];
+    size_t len;
+    uint64_t batch_end_time;
+    while ((len = gps_rx_read(buf, sizeof(buf), &batch_end_time)))
+    {
+        const uint32_t parse_start = time_us_32();
+        for (size_t i = 0; i < len; i++)
+        {
+            /* Work back from the last byte of the batch to when the start bit of the '$' arrived */
+            if (buf[i] == '$')
+            {
+                sentence_start_time = batch_end_time - gps_rx_bytes_to_us(len - i);
+
+                /* The module sends each burst without pauses, so only a '$' after an idle line starts one
+                 * (Bytes within a batch are assumed to have arrived back to back, so only the first can follow a gap) */
+                if (i == 0 && int64_t(sentence_start_time - last_byte_time) >= GPS_BURST_GAP_US)
+                {
+                    burst_start_time = sentence_start_time;
+                    burst_first_sentence = true;
+                    burst_valid = false;
+                }
+            }
+            gps_handle_character(buf[i]);
+        }
+        last_byte_time = batch_end_time;
+        gps_data.stats.parser.parse_time += time_us_32() - parse_start;
+    }
+
     gps_data.perf.end_loop();
+    publish();
 }
 
 void gps_thread_func()
@@ -323,6 +946,8 @@ void gps_thread_func()
     while (1)
     {
         gps_loop();
-        sleep_us(1);
+
+        /* Sleep until more data is received, waking often enough to keep the watchdog happy */
+        gps_rx_wait(WATCHDOG_GPS_TIME * 1000 / 4);
     }
 }
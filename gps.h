@@ -38,6 +38,7 @@
 #include "config.h"
 
 #include "loop_measurer.h"
+#include "unix_time.h"
 
 /**
  * Initializes GPS, then runs the GPS main loop
@@ -59,10 +60,48 @@ void gps_init();
 /**
  * Loop function for GPS
  *
- * This *must* be called very frequently in order to empty the UART FIFO
+ * Handles all characters queued by the RX interrupt, this must be called often enough to keep the ring buffer from filling up
  */
 void gps_loop();
 
+/** Size of the NMEA sentence buffers */
+#define NMEA_BUFFER_SIZE 512
+
+/** Maximum number of fields in a NMEA sentence (Including the ID, but not the checksum) */
+#define GPS_NMEA_MAX_FIELDS 32
+
+struct gps_parser_stats_t
+{
+    /** Number of bytes handled by the parser */
+    uint32_t bytes;
+    /** Number of valid sentences */
+    uint32_t sentences;
+    /** Number of sentences dropped because of a bad or malformed checksum */
+    uint32_t checksum_errors;
+    /** Number of sentences dropped because they were too long or had too many fields */
+    uint32_t overflows;
+    /** Number of sentences dropped because the checksum was not followed by the end of the line */
+    uint32_t framing_errors;
+    /** Number of valid sentences without a handler */
+    uint32_t unhandled;
+    /** Time in microseconds spent parsing */
+    uint32_t parse_time;
+};
+
+struct gps_sync_stats_t
+{
+    /** Number of times the clock was set */
+    uint32_t count;
+    /** Number of times the clock was set to a PPS pulse */
+    uint32_t pps_count;
+    /** Number of syncs skipped because the sentence could not be timed (Not paired with a recent PPS pulse, or the start of its output burst was not seen) */
+    uint32_t skipped;
+    /** How far ahead the clock was at the last sync, in microseconds */
+    microseconds_t residual;
+    /** Time in microseconds between the start of the last sync sentence arriving and it being parsed */
+    microseconds_t parse_delay;
+};
+
 enum gps_fix_status_t : int
 {
     GPS_NO_FIX,
@@ -70,35 +109,97 @@ enum gps_fix_status_t : int
     GPS_DIFFERENTIAL_FIX
 };
 
-/**
- * GPS module internal data
- *
- * Struct must be zero-initialized
- */
-struct gps_data_t
+struct gps_fix_t
 {
-    char firmware_release_str[256];
-    char firmware_build_id[256];
-    char firmware_internal_1[256];
-    char firmware_internal_2[256];
-
     gps_fix_status_t fix_status;
 
-    int satellites_used;
+    int32_t satellites_used;
+    /** Only updated if GSV output is enabled, which gps_set_config() leaves off */
+    int32_t satellites_in_view;
+
+    /** Fix mode reported by GSA [1: No fix, 2: 2D, 3: 3D] */
+    int32_t fix_mode;
+
+    /** RMC status field was 'A' (Valid) */
+    bool rmc_valid;
+
+    /** Latitude in degrees scaled by 10^7, positive is north */
+    int32_t latitude;
+    /** Longitude in degrees scaled by 10^7, positive is east */
+    int32_t longitude;
+    /** Altitude above mean sea level in decimeters */
+    int32_t altitude;
+    /** Speed over ground in hundredths of a knot */
+    int32_t speed;
+    /** Course over ground in hundredths of a degree */
+    int32_t course;
+
+    /** Dilution of precision values, scaled by 100 */
+    int32_t pdop;
+    int32_t hdop;
+    int32_t vdop;
+};
 
-    /** Time to reach before gps_loop() will call gps_set_config() */
-    absolute_time_t next_config_sync;
+struct gps_firmware_t
+{
+    char release_str[256];
+    char build_id[256];
+    char internal_1[256];
+    char internal_2[256];
+};
 
-    /** If this time is reached then that indicates a hang for the GPS thread */
-    absolute_time_t watchdog_expiry_time;
+struct gps_stats_t
+{
+    gps_parser_stats_t parser;
 
-    char nmea_last_full[512]; /**< Last fully received sentence */
-    size_t nmea_last_full_len; /**< Length of `nmea_last_full` */
+    gps_sync_stats_t sync;
 
-    char nmea_in_progress[512]; /**< Sentence currently being received, may be empty */
-    size_t nmea_in_progress_len; /**< Length of `nmea_in_progress` */
+    /** Command ID of the last PMTK001 acknowledgement */
+    int32_t last_ack_command;
+    /** Flag of the last PMTK001 acknowledgement [0: Invalid command, 1: Unsupported command, 2: Failed, 3: Success] */
+    int32_t last_ack_flag;
+    /** Number of PMTK001 acknowledgements that did not report success */
+    uint32_t failed_acks;
 
-    loop_measure_t perf;
+    microseconds_t average_loop_time;
+    float loops_per_second;
 };
 
-extern gps_data_t gps_data;
+struct gps_nmea_t
+{
+    char sentence[NMEA_BUFFER_SIZE];
+};
+
+/**
+ * Copy of GPS data for use outside of the GPS thread
+ *
+ * Struct must be zero-initialized
+ */
+struct gps_snapshot_t
+{
+    gps_fix_t fix;
+    gps_firmware_t firmware;
+    gps_stats_t stats;
+
+    /** Last fully received sentence */
+    gps_nmea_t nmea_last_full;
+
+    /** Versions of each section as of the last update, sections are only copied when their version changes */
+    uint32_t fix_version;
+    uint32_t firmware_version;
+    uint32_t stats_version;
+    uint32_t nmea_version;
+};
+
+/**
+ * Bring a snapshot up to date with the data published by the GPS thread
+ *
+ * Each section is internally consistent, and is only copied if it changed since the snapshot was last updated.
+ * The GPS thread publishes at the end of every gps_loop() pass.
+ */
+void gps_update_snapshot(gps_snapshot_t& snapshot);
+
+/**
+ * Get the time after which the GPS thread should be considered hung
+ */
+absolute_time_t gps_get_watchdog_expiry_time();
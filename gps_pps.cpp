@@ -0,0 +1,82 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief GPS 1PPS capture (Implementation)
+ */
+#include "gps_pps.h"
+
+#include "config.h"
+#include "seqlock.h"
+
+#include "hardware/gpio.h"
+#include "pico/time.h"
+
+struct pps_state_t
+{
+    /** Rising edge time of the most recent pulse */
+    uint64_t last_pulse;
+    /** Number of pulses captured */
+    uint32_t count;
+};
+
+/** Written only by the capture interrupt, read from either core */
+static seqlock_t<pps_state_t> state = {};
+
+static void capture(const uint64_t time)
+{
+    pps_state_t& s = state.write_begin();
+    s.last_pulse = time;
+    s.count++;
+    state.write_end();
+}
+
+static void gpio_callback(uint gpio, uint32_t event_mask)
+{
+    const uint64_t now = time_us_64();
+    if (gpio == GPS_PPS_PIN && (event_mask & GPIO_IRQ_EDGE_RISE))
+        capture(now);
+}
+
+void gps_pps_init()
+{
+    gpio_init(GPS_PPS_PIN);
+    gpio_set_dir(GPS_PPS_PIN, GPIO_IN);
+    /* Keep the pin quiet if the PPS output is not connected */
+    gpio_pull_down(GPS_PPS_PIN);
+    gpio_set_irq_enabled_with_callback(GPS_PPS_PIN, GPIO_IRQ_EDGE_RISE, true, gpio_callback);
+}
+
+bool gps_pps_get_last(uint64_t& time)
+{
+    const pps_state_t s = state.read();
+    time = s.last_pulse;
+    return s.count != 0;
+}
+
+uint32_t gps_pps_get_count() { return state.read().count; }
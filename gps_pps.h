@@ -0,0 +1,57 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief GPS 1PPS capture
+ */
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Start capturing pulses from @ref GPS_PPS_PIN
+ *
+ * Host builds use the scripted source in tests/host_pps.h instead
+ *
+ * The edge interrupt is handled by the core that calls this function
+ */
+void gps_pps_init();
+
+/**
+ * Get the time of the most recent pulse
+ *
+ * @param time Set to the `time_us_64()` value of the pulse's rising edge
+ *
+ * @returns False if no pulse has been captured yet
+ */
+bool gps_pps_get_last(uint64_t& time);
+
+/**
+ * Get number of pulses captured
+ */
+uint32_t gps_pps_get_count();
@@ -0,0 +1,243 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief GPS UART receive (Implementation)
+ */
+#include "gps_rx.h"
+
+#include "config.h"
+
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/time.h"
+
+#include <string.h>
+
+static_assert(GPS_RX_BUFFER_SIZE && (GPS_RX_BUFFER_SIZE & (GPS_RX_BUFFER_SIZE - 1)) == 0, "GPS_RX_BUFFER_SIZE must be a power of two");
+
+static volatile gps_rx_stats_t stats = {};
+
+/** Bits on the wire for each byte, including start/stop/parity bits */
+#define GPS_RX_BITS_PER_BYTE (1 + GPS_DATA_BITS + GPS_STOP_BITS + (GPS_PARITY != UART_PARITY_NONE))
+
+uint32_t gps_rx_bytes_to_us(const uint32_t bytes) { return uint64_t(bytes) * GPS_RX_BITS_PER_BYTE * 1000000 / GPS_BAUD_RATE; }
+
+#if GPS_RX_USE_DMA
+#include "hardware/dma.h"
+
+/** Largest transfer count the DMA can be armed with */
+#define DMA_TRANS_COUNT_MAX 0xFFFFFFFFu
+
+/** The DMA write address wraps on a GPS_RX_BUFFER_SIZE boundary, so the ring must be aligned to it */
+static uint8_t dma_ring[GPS_RX_BUFFER_SIZE] __attribute__((aligned(GPS_RX_BUFFER_SIZE)));
+
+static int dma_chan = -1;
+
+/** Bytes written by previous arms of the channel */
+static uint32_t dma_base = 0;
+
+/** Free running read counter */
+static uint32_t dma_tail = 0;
+
+/**
+ * Get the free running write counter
+ */
+static uint32_t dma_head()
+{
+    /* The channel stops once the transfer count runs out (~51 days at 9600 baud), re-arm it without moving the write address */
+    if (!dma_channel_is_busy(dma_chan))
+    {
+        dma_base += DMA_TRANS_COUNT_MAX - dma_hw->ch[dma_chan].transfer_count;
+        dma_channel_set_trans_count(dma_chan, DMA_TRANS_COUNT_MAX, true);
+    }
+
+    return dma_base + (DMA_TRANS_COUNT_MAX - dma_hw->ch[dma_chan].transfer_count);
+}
+
+void gps_rx_init()
+{
+    dma_chan = dma_claim_unused_channel(true);
+
+    uint log2_size = 0;
+    while ((1u << log2_size) < GPS_RX_BUFFER_SIZE)
+        log2_size++;
+
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, log2_size);
+    channel_config_set_dreq(&c, UART_DREQ_NUM(GPS_UART_ID, false));
+
+    dma_channel_configure(dma_chan, &c, dma_ring, &uart_get_hw(GPS_UART_ID)->dr, DMA_TRANS_COUNT_MAX, true);
+
+    /* DMA reads of the data register lose the error flags, so overruns are detected through the sticky flags in UARTRSR */
+    hw_set_bits(&uart_get_hw(GPS_UART_ID)->dmacr, UART_UARTDMACR_RXDMAE_BITS);
+}
+
+size_t gps_rx_read(uint8_t* buf, const size_t max_len, uint64_t* last_byte_time)
+{
+    uart_hw_t* const hw = uart_get_hw(GPS_UART_ID);
+
+    /* Bytes land in the ring as they arrive, so the newest byte arrived at some point since the last poll.
+     * Assume it arrived now, this is late by at most GPS_RX_DMA_POLL_INTERVAL */
+    const uint64_t now = time_us_64();
+    if (hw->rsr & UART_UARTRSR_OE_BITS)
+    {
+        hw->rsr = UART_UARTRSR_OE_BITS;
+        stats.fifo_overruns++;
+    }
+
+    const uint32_t head = dma_head();
+    stats.bytes_received = head;
+
+    uint32_t avail = head - dma_tail;
+
+    if (avail > stats.high_water_mark)
+        stats.high_water_mark = avail;
+
+    /* The DMA lapped the reader, whatever is in the ring is a mix of old and new data so drop all of it */
+    if (avail > GPS_RX_BUFFER_SIZE)
+    {
+        stats.ring_overruns += avail;
+        dma_tail = head;
+        return 0;
+    }
+
+    if (avail > max_len)
+        avail = max_len;
+
+    const uint32_t pos = dma_tail & (GPS_RX_BUFFER_SIZE - 1);
+    const uint32_t first = (pos + avail > GPS_RX_BUFFER_SIZE) ? GPS_RX_BUFFER_SIZE - pos : avail;
+    memcpy(buf, dma_ring + pos, first);
+    memcpy(buf + first, dma_ring, avail - first);
+
+    dma_tail += avail;
+
+    if (last_byte_time)
+        *last_byte_time = now - gps_rx_bytes_to_us(head - dma_tail);
+
+    return avail;
+}
+
+bool gps_rx_available() { return dma_head() != dma_tail; }
+
+void gps_rx_wait(const uint32_t timeout_us)
+{
+    /* There is no per-byte interrupt to wake on, so poll at a rate that keeps up with the ring filling */
+    sleep_us(timeout_us < GPS_RX_DMA_POLL_INTERVAL ? timeout_us : GPS_RX_DMA_POLL_INTERVAL);
+}
+#else
+#include "ring_buffer.h"
+
+#include "hardware/irq.h"
+
+static spsc_ring_t<uint8_t, GPS_RX_BUFFER_SIZE> ring = {};
+
+/** Value of `ring.head` when the RX interrupt last ran */
+static uint32_t stamp_head = 0;
+/** Estimated `time_us_64()` value at which the byte before `stamp_head` finished arriving */
+static uint64_t stamp_time = 0;
+
+static void __isr gps_rx_irq_handler()
+{
+    uart_hw_t* const hw = uart_get_hw(GPS_UART_ID);
+
+    /* The FIFO level interrupt fires as the newest byte arrives, but the timeout interrupt fires 32 bit periods after it */
+    uint64_t now = time_us_64();
+    if (hw->mis & UART_UARTMIS_RTMIS_BITS)
+        now -= 32 * 1000000 / GPS_BAUD_RATE;
+
+    while (uart_is_readable(GPS_UART_ID))
+    {
+        const uint32_t dr = hw->dr;
+
+        if (dr & UART_UARTDR_OE_BITS)
+            stats.fifo_overruns++;
+
+        if (ring.push(dr & 0xFF))
+            stats.bytes_received++;
+        else
+            stats.ring_overruns++;
+    }
+
+    stamp_head = ring.head;
+    stamp_time = now;
+
+    const uint32_t size = ring.size();
+    if (size > stats.high_water_mark)
+        stats.high_water_mark = size;
+
+    /* Wake the consumer if it is waiting in gps_rx_wait() */
+    __sev();
+}
+
+void gps_rx_init()
+{
+    const uint irq = UART_IRQ_NUM(GPS_UART_ID);
+    irq_set_exclusive_handler(irq, gps_rx_irq_handler);
+    irq_set_enabled(irq, true);
+
+    /* RX and RX timeout interrupts */
+    uart_set_irq_enables(GPS_UART_ID, true, false);
+}
+
+size_t gps_rx_read(uint8_t* buf, const size_t max_len, uint64_t* last_byte_time)
+{
+    /* The interrupt is handled on this core, so masking it keeps the stamp consistent with the bytes popped */
+    const uint32_t irq_state = save_and_disable_interrupts();
+    const size_t len = ring.pop(buf, max_len);
+    const uint32_t head = stamp_head;
+    const uint64_t time = stamp_time;
+    restore_interrupts(irq_state);
+
+    if (last_byte_time)
+        *last_byte_time = time - gps_rx_bytes_to_us(head - ring.tail);
+
+    return len;
+}
+
+bool gps_rx_available() { return ring.size() != 0; }
+
+void gps_rx_wait(const uint32_t timeout_us)
+{
+    if (!gps_rx_available())
+        best_effort_wfe_or_timeout(make_timeout_time_us(timeout_us));
+}
+#endif
+
+gps_rx_stats_t gps_rx_get_stats()
+{
+    gps_rx_stats_t r;
+    r.bytes_received = stats.bytes_received;
+    r.high_water_mark = stats.high_water_mark;
+    r.ring_overruns = stats.ring_overruns;
+    r.fifo_overruns = stats.fifo_overruns;
+    return r;
+}
@@ -0,0 +1,93 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief GPS UART receive
+ *
+ * Received bytes are either queued by the UART RX interrupt, or copied by DMA when @ref GPS_RX_USE_DMA is set
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct gps_rx_stats_t
+{
+    /** Total number of bytes received */
+    uint32_t bytes_received;
+    /** Highest number of bytes waiting in the ring buffer */
+    uint32_t high_water_mark;
+    /** Number of bytes dropped because the ring buffer was full (or with DMA, lapped by the write pointer) */
+    uint32_t ring_overruns;
+    /** Number of times the UART hardware FIFO overflowed before the interrupt handler could empty it */
+    uint32_t fifo_overruns;
+};
+
+/**
+ * Start receiving from @ref GPS_UART_ID
+ *
+ * The receive interrupt is handled by the core that calls this function
+ *
+ * @warning The UART must already be initialized
+ */
+void gps_rx_init();
+
+/**
+ * Copy received bytes out of the ring buffer
+ *
+ * @param buf Buffer to copy to
+ * @param max_len Size of buffer
+ * @param last_byte_time If not NULL, set to the estimated `time_us_64()` value at which the last copied byte finished arriving
+ *
+ * @returns Number of bytes copied
+ */
+size_t gps_rx_read(uint8_t* buf, const size_t max_len, uint64_t* last_byte_time = NULL);
+
+/**
+ * Get the time it takes to receive a number of bytes
+ *
+ * @returns Time in microseconds
+ */
+uint32_t gps_rx_bytes_to_us(const uint32_t bytes);
+
+/**
+ * Check if any received bytes are waiting in the ring buffer
+ */
+bool gps_rx_available();
+
+/**
+ * Wait until bytes are received or `timeout_us` microseconds pass
+ *
+ * May return early
+ */
+void gps_rx_wait(const uint32_t timeout_us);
+
+/**
+ * Get receive counters
+ */
+gps_rx_stats_t gps_rx_get_stats();
@@ -0,0 +1,117 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Multi-stop gradient generator (Implementation)
+ */
+#include "gradient.h"
+
+#include <string.h>
+
+/**
+ * Get the index of the first pixel at or after a gradient position
+ *
+ * @param pos Q16 gradient position
+ * @param span Number of pixels minus 1
+ */
+static size_t gradient_pixel_at(const uint32_t pos, const uint32_t span)
+{
+    return (uint64_t(pos) * span + GRADIENT_POS_ONE - 1) >> 16;
+}
+
+static inline led_pixel_t gradient_pack(const rgbw_q8_t& c) { return led_pack(c.r >> 8, c.g >> 8, c.b >> 8, c.w >> 8); }
+
+/**
+ * Fill pixels [first, end) between two stops
+ *
+ * Channels are stepped with 16 fractional bits (instead of 8), which keeps the accumulated error well below 1/255 for very long strips.
+ * The deltas are rounded towards zero, so the channels never step outside the range set by the two stops.
+ */
+static void gradient_fill_segment(const gradient_stop_t& from, const gradient_stop_t& to, size_t first, const size_t end, const uint32_t span, led_pixel_t* out)
+{
+    /* Pixel i is at gradient position (i * GRADIENT_POS_ONE / span), everything is scaled by span to keep it in integers */
+    const int64_t denominator = int64_t(span) * (to.pos - from.pos);
+    const int64_t offset = int64_t(first) * GRADIENT_POS_ONE - int64_t(from.pos) * span;
+
+    const int32_t from_c[4] = { int32_t(from.color.r), int32_t(from.color.g), int32_t(from.color.b), int32_t(from.color.w) };
+    const int32_t to_c[4] = { int32_t(to.color.r), int32_t(to.color.g), int32_t(to.color.b), int32_t(to.color.w) };
+
+    int32_t acc[4];
+    int32_t delta[4];
+    for (int c = 0; c < 4; c++)
+    {
+        const int64_t diff = int64_t(to_c[c] - from_c[c]) << 8;
+        acc[c] = (from_c[c] << 8) + int32_t(diff * offset / denominator);
+        delta[c] = diff * GRADIENT_POS_ONE / denominator;
+    }
+
+    int32_t r = acc[0], g = acc[1], b = acc[2], w = acc[3];
+    for (; first < end; first++)
+    {
+        out[first] = led_pack(r >> 16, g >> 16, b >> 16, w >> 16);
+        r += delta[0];
+        g += delta[1];
+        b += delta[2];
+        w += delta[3];
+    }
+}
+
+void gradient_fill(const gradient_stop_t* stops, const size_t num_stops, led_pixel_t* out, const size_t num_pixels)
+{
+    if (!num_stops)
+    {
+        memset((void*)out, 0, sizeof(*out) * num_pixels);
+        return;
+    }
+
+    const uint32_t span = num_pixels > 1 ? num_pixels - 1 : 1;
+
+    size_t i = 0;
+
+    /* Pixels before the first stop */
+    const led_pixel_t first_color = gradient_pack(stops[0].color);
+    for (const size_t end = gradient_pixel_at(stops[0].pos, span); i < end && i < num_pixels; i++)
+        out[i] = first_color;
+
+    for (size_t s = 0; s + 1 < num_stops; s++)
+    {
+        size_t end = gradient_pixel_at(stops[s + 1].pos, span);
+        if (end > num_pixels)
+            end = num_pixels;
+        if (i >= end)
+            continue;
+
+        gradient_fill_segment(stops[s], stops[s + 1], i, end, span, out);
+        i = end;
+    }
+
+    /* Pixels at or after the last stop */
+    const led_pixel_t last_color = gradient_pack(stops[num_stops - 1].color);
+    for (; i < num_pixels; i++)
+        out[i] = last_color;
+}
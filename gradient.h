@@ -0,0 +1,69 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Multi-stop gradient generator
+ */
+#pragma once
+
+#include "led.h"
+
+/** Gradient position of the last pixel */
+#define GRADIENT_POS_ONE (1 << 16)
+
+/**
+ * RGBW color with Q8.8 components in the range [0, 255 << 8]
+ */
+struct rgbw_q8_t
+{
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+    uint32_t w;
+};
+
+struct gradient_stop_t
+{
+    /** Q16 position in the range [0, @ref GRADIENT_POS_ONE], 0 is the first pixel and @ref GRADIENT_POS_ONE is the last pixel */
+    uint32_t pos;
+    /** Color at `pos` */
+    rgbw_q8_t color;
+};
+
+/**
+ * Fill led color array with a linear gradient
+ *
+ * Pixels before the first stop or after the last stop get the color of that stop.
+ * Each pixel between two stops only costs a few additions, as the color is stepped by a constant delta.
+ *
+ * @param stops Gradient stops, must be sorted by position
+ * @param num_stops Number of gradient stops, if 0 all pixels are turned off
+ * @param out Array to fill
+ * @param num_pixels Length of array to fill
+ */
+void gradient_fill(const gradient_stop_t* stops, const size_t num_stops, led_pixel_t* out, const size_t num_pixels);
@@ -35,41 +35,416 @@
 
 #include "config.h"
 
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "pico/time.h"
+#include <stdlib.h>
+#include <string.h>
+
 #include "ws2812.pio.h"
 
-static PIO pio = {};
-static uint sm = {};
-static uint offset = {};
+static_assert(LED_BYTE_POS_R != LED_BYTE_POS_G && LED_BYTE_POS_R != LED_BYTE_POS_B && LED_BYTE_POS_R != LED_BYTE_POS_W && LED_BYTE_POS_G != LED_BYTE_POS_B
+        && LED_BYTE_POS_G != LED_BYTE_POS_W && LED_BYTE_POS_B != LED_BYTE_POS_W,
+    "LED_BYTE_POS_* must be unique");
+static_assert(LED_BYTE_POS_R < 4 && LED_BYTE_POS_G < 4 && LED_BYTE_POS_B < 4 && LED_BYTE_POS_W < 4, "LED_BYTE_POS_* must be in the range [0,3]");
+
+/** Number of words the joined TX FIFO and the OSR can hold after DMA has finished */
+#define LED_PIO_QUEUE_DEPTH 9
 
-void led_init(const bool is_rgbw, const uint32_t frequency, const uint32_t gpio)
+/**
+ * State machine and DMA channel pair
+ */
+struct led_stream_t
 {
-    bool success = pio_claim_free_sm_and_add_program_for_gpio_range(&ws2812_program, &pio, &sm, &offset, gpio, 1, true);
+    PIO pio;
+    uint sm;
+    uint offset;
+    const pio_program_t* program;
+    int dma_chan;
+
+    /** First pixel of the framebuffer sent by this stream (Only used by segments) */
+    size_t first_pixel;
+    /** Number of pixels sent by this stream (Only used by segments) */
+    size_t pixel_count;
+    /** Shift amounts for moving components from the framebuffer byte order to the segment byte order, indexed by framebuffer byte */
+    uint8_t swizzle_shift[4];
+    /** Segment byte order matches the framebuffer byte order */
+    bool is_native;
+    /** Staging buffers for segments that need swizzling, NULL for native segments */
+    led_pixel_t* staging[2];
+};
+
+static led_stream_t streams[LED_MAX_SEGMENTS] = {};
+static uint32_t stream_count = 0;
+
+/** Set if led_init_segments() was used */
+static bool is_segmented = false;
+
+static bool is_rgbw = false;
+
+/** Number of strips driven by @ref ws2812_parallel, 0 if @ref ws2812 is used */
+static uint32_t parallel_strip_count = 0;
+
+/** Framebuffers, one is rendered to while the other is being read by DMA */
+static led_pixel_t buffers[2][LED_PIXEL_COUNT];
+/** Bit plane buffers for @ref ws2812_parallel, one is written to while the other is being read by DMA */
+static uint32_t* planes[2] = {};
+static uint32_t back_buffer = 0;
+
+/** Number of pixels in the last push, 0 if nothing has been pushed yet */
+static size_t last_push_len = 0;
+/** Time of the last push that was not skipped */
+static absolute_time_t last_push_time = {};
+
+static led_stats_t stats = {};
+
+/** Time it takes for the PIO queue to drain and the strip to latch once DMA has finished */
+static uint64_t latch_delay_us = 0;
+
+/** Bitmask of DMA channels still reading the current push */
+static volatile uint32_t dma_pending_mask = 0;
+/**
+ * Only valid when `dma_pending_mask` is 0
+ *
+ * Written by the DMA IRQ before it clears `dma_pending_mask`, and only read after seeing it clear,
+ * with compiler barriers on both sides so the accesses are not reordered around the mask
+ */
+static absolute_time_t latch_time = {};
+
+static volatile led_push_complete_callback_t push_complete_callback = NULL;
+
+static void __isr led_dma_irq_handler()
+{
+    uint32_t pending = dma_pending_mask;
+    if (!pending)
+        return;
+
+    for (uint32_t i = 0; i < stream_count; i++)
+    {
+        const int chan = streams[i].dma_chan;
+        if (chan < 0 || !dma_channel_get_irq0_status(chan))
+            continue;
+        dma_channel_acknowledge_irq0(chan);
+        pending &= ~(1u << chan);
+    }
+
+    if (pending)
+    {
+        dma_pending_mask = pending;
+        return;
+    }
+
+    latch_time = make_timeout_time_us(latch_delay_us);
+    __compiler_memory_barrier();
+    dma_pending_mask = 0;
+
+    led_push_complete_callback_t callback = push_complete_callback;
+    if (callback)
+        callback();
+}
+
+/**
+ * Claim a state machine and setup its DMA channel
+ *
+ * @param program Program to load, the caller is responsible for calling the program's init function
+ * @param bits_per_word Number of datastream bits each word in the TX FIFO represents
+ */
+static led_stream_t& led_add_stream(const pio_program_t* program, const uint32_t gpio_base, const uint32_t gpio_count, const uint32_t frequency,
+    const uint64_t bits_per_word)
+{
+    hard_assert(stream_count < LED_MAX_SEGMENTS);
+    led_stream_t& stream = streams[stream_count++];
+    stream = {};
+
+    stream.program = program;
+    bool success = pio_claim_free_sm_and_add_program_for_gpio_range(program, &stream.pio, &stream.sm, &stream.offset, gpio_base, gpio_count, true);
     hard_assert(success);
 
-    ws2812_program_init(pio, sm, offset, gpio, frequency, is_rgbw);
+    const uint64_t stream_latch_delay_us = (LED_PIO_QUEUE_DEPTH * bits_per_word * 1000000ull) / frequency + LED_RESET_TIME;
+    if (stream_latch_delay_us > latch_delay_us)
+        latch_delay_us = stream_latch_delay_us;
+    latch_time = get_absolute_time();
+
+    stream.dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(stream.dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(stream.pio, stream.sm, true));
+    dma_channel_configure(stream.dma_chan, &c, &stream.pio->txf[stream.sm], NULL, 0, false);
+
+    if (stream_count == 1)
+        irq_add_shared_handler(DMA_IRQ_0, led_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq0_enabled(stream.dma_chan, true);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    return stream;
+}
+
+void led_init(const bool _is_rgbw, const uint32_t frequency, const uint32_t gpio)
+{
+    led_stream_t& stream = led_add_stream(&ws2812_program, gpio, 1, frequency, _is_rgbw ? 32 : 24);
+    ws2812_program_init(stream.pio, stream.sm, stream.offset, gpio, frequency, _is_rgbw);
+
+    is_rgbw = _is_rgbw;
+}
+
+void led_init_parallel(const bool _is_rgbw, const uint32_t frequency, const uint32_t gpio_base, const uint32_t strip_count)
+{
+    hard_assert(strip_count >= 1 && strip_count <= LED_PARALLEL_MAX_STRIPS);
+    hard_assert(LED_PIXEL_COUNT % strip_count == 0);
+
+    led_stream_t& stream = led_add_stream(&ws2812_parallel_program, gpio_base, strip_count, frequency, 1);
+    ws2812_parallel_program_init(stream.pio, stream.sm, stream.offset, gpio_base, strip_count, frequency);
+
+    is_rgbw = _is_rgbw;
+    parallel_strip_count = strip_count;
+
+    /* Each bit of every pixel is sent as a single word */
+    for (int i = 0; i < 2; i++)
+    {
+        planes[i] = (uint32_t*)calloc((LED_PIXEL_COUNT / strip_count) * 32, sizeof(uint32_t));
+        hard_assert(planes[i]);
+    }
 }
 
-void led_push(const led_color_t* data, const size_t data_len, const led_swizzle_config_t& swizzle_config)
+void led_init_segments(const led_segment_config_t* segments, const size_t segment_count, const uint32_t frequency)
 {
-    for (size_t i = 0; i < data_len; i++)
+    hard_assert(segment_count >= 1 && segment_count <= LED_MAX_SEGMENTS);
+
+    const uint8_t native_byte_pos[4] = { LED_BYTE_POS_R, LED_BYTE_POS_G, LED_BYTE_POS_B, LED_BYTE_POS_W };
+
+    size_t first_pixel = 0;
+    for (size_t i = 0; i < segment_count; i++)
     {
-        union
+        const led_segment_config_t& config = segments[i];
+
+        led_stream_t& stream = led_add_stream(&ws2812_program, config.gpio, 1, frequency, config.is_rgbw ? 32 : 24);
+        ws2812_program_init(stream.pio, stream.sm, stream.offset, config.gpio, frequency, config.is_rgbw);
+
+        stream.first_pixel = first_pixel;
+        stream.pixel_count = config.pixel_count;
+        first_pixel += config.pixel_count;
+
+        const int8_t segment_byte_pos[4] = { config.byte_pos_r, config.byte_pos_g, config.byte_pos_b, config.byte_pos_w };
+        stream.is_native = true;
+        for (int c = 0; c < 4; c++)
+        {
+            hard_assert(segment_byte_pos[c] >= 0 && segment_byte_pos[c] < 4);
+            stream.swizzle_shift[native_byte_pos[c]] = segment_byte_pos[c] * 8;
+            if (segment_byte_pos[c] != native_byte_pos[c])
+                stream.is_native = false;
+        }
+
+        /* Native segments are read straight from the framebuffer */
+        for (int j = 0; j < 2 && !stream.is_native; j++)
         {
-            uint8_t bytes[4];
-            uint32_t word;
-        } c;
-        c.bytes[swizzle_config.byte_pos_r] = data[i].r;
-        c.bytes[swizzle_config.byte_pos_g] = data[i].g;
-        c.bytes[swizzle_config.byte_pos_b] = data[i].b;
-        c.bytes[swizzle_config.byte_pos_w] = data[i].w;
-        pio_sm_put_blocking(pio, sm, c.word);
+            stream.staging[j] = (led_pixel_t*)calloc(config.pixel_count, sizeof(led_pixel_t));
+            hard_assert(stream.staging[j]);
+        }
     }
+
+    hard_assert(first_pixel == LED_PIXEL_COUNT);
+
+    is_segmented = true;
 }
 
+void led_transpose_planes(const led_pixel_t* const* strips, const size_t strip_count, const size_t pixel_count, const bool rgbw, uint32_t* out)
+{
+    /* Non-RGBW strips only receive the upper 24 bits of each pixel, see ws2812_program_init() */
+    const int lowest_byte = rgbw ? 0 : 1;
+
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        for (int byte = 3; byte >= lowest_byte; byte--)
+        {
+            const int shift = byte * 8;
+
+            /* Rows are loaded in reverse so that strip N ends up in bit N of the output */
+            uint8_t rows[8] = {};
+            for (size_t s = 0; s < strip_count; s++)
+                rows[7 - s] = strips[s][i] >> shift;
+
+            /* 8x8 bit matrix transpose, from Hacker's Delight (2nd Edition) section 7-3 */
+            uint32_t x = (uint32_t(rows[0]) << 24) | (uint32_t(rows[1]) << 16) | (uint32_t(rows[2]) << 8) | rows[3];
+            uint32_t y = (uint32_t(rows[4]) << 24) | (uint32_t(rows[5]) << 16) | (uint32_t(rows[6]) << 8) | rows[7];
+            uint32_t t;
+
+            t = (x ^ (x >> 7)) & 0x00AA00AA, x = x ^ t ^ (t << 7);
+            t = (y ^ (y >> 7)) & 0x00AA00AA, y = y ^ t ^ (t << 7);
+
+            t = (x ^ (x >> 14)) & 0x0000CCCC, x = x ^ t ^ (t << 14);
+            t = (y ^ (y >> 14)) & 0x0000CCCC, y = y ^ t ^ (t << 14);
+
+            t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+            y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+            x = t;
+
+            /* Most significant bit first, matching ws2812_program_init() */
+            *out++ = (x >> 24) & 0xFF;
+            *out++ = (x >> 16) & 0xFF;
+            *out++ = (x >> 8) & 0xFF;
+            *out++ = x & 0xFF;
+            *out++ = (y >> 24) & 0xFF;
+            *out++ = (y >> 16) & 0xFF;
+            *out++ = (y >> 8) & 0xFF;
+            *out++ = y & 0xFF;
+        }
+    }
+}
+
+led_pixel_t* led_get_framebuffer() { return buffers[back_buffer]; }
+
+/**
+ * Copy pixels while moving each byte to the position the segment expects
+ */
+static void led_swizzle(const led_stream_t& stream, const led_pixel_t* in, led_pixel_t* out, const size_t pixel_count)
+{
+    const uint8_t s0 = stream.swizzle_shift[0];
+    const uint8_t s1 = stream.swizzle_shift[1];
+    const uint8_t s2 = stream.swizzle_shift[2];
+    const uint8_t s3 = stream.swizzle_shift[3];
+
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        const led_pixel_t p = in[i];
+        out[i] = ((p & 0xFF) << s0) | (((p >> 8) & 0xFF) << s1) | (((p >> 16) & 0xFF) << s2) | ((p >> 24) << s3);
+    }
+}
+
+bool led_push_framebuffer(const size_t data_len)
+{
+    hard_assert(data_len <= LED_PIXEL_COUNT);
+
+    const led_pixel_t* const framebuffer = buffers[back_buffer];
+
+    /* The front buffer always holds the last frame that was pushed */
+    if (data_len == last_push_len && memcmp(framebuffer, buffers[back_buffer ^ 1], data_len * sizeof(led_pixel_t)) == 0
+        && !time_reached(delayed_by_us(last_push_time, LED_FORCED_REFRESH_INTERVAL)))
+    {
+        stats.frames_skipped++;
+        return false;
+    }
+
+    const uint32_t* src[LED_MAX_SEGMENTS] = {};
+    size_t src_len[LED_MAX_SEGMENTS] = {};
+
+    if (is_segmented)
+    {
+        for (uint32_t i = 0; i < stream_count; i++)
+        {
+            const led_stream_t& stream = streams[i];
+            if (stream.first_pixel >= data_len)
+                continue;
+
+            src_len[i] = data_len - stream.first_pixel;
+            if (src_len[i] > stream.pixel_count)
+                src_len[i] = stream.pixel_count;
+
+            src[i] = framebuffer + stream.first_pixel;
+            if (!stream.is_native)
+            {
+                led_swizzle(stream, src[i], stream.staging[back_buffer], src_len[i]);
+                src[i] = stream.staging[back_buffer];
+            }
+        }
+    }
+    else if (parallel_strip_count)
+    {
+        hard_assert(data_len % parallel_strip_count == 0);
+
+        const size_t strip_len = data_len / parallel_strip_count;
+        const led_pixel_t* strips[LED_PARALLEL_MAX_STRIPS];
+        for (uint32_t i = 0; i < parallel_strip_count; i++)
+            strips[i] = framebuffer + i * strip_len;
+
+        led_transpose_planes(strips, parallel_strip_count, strip_len, is_rgbw, planes[back_buffer]);
+
+        src[0] = planes[back_buffer];
+        src_len[0] = strip_len * (is_rgbw ? 32 : 24);
+    }
+    else
+    {
+        src[0] = framebuffer;
+        src_len[0] = data_len;
+    }
+
+    led_wait_for_push();
+
+    /* Arm every channel first, then start them together so all segments are transmitted concurrently */
+    uint32_t start_mask = 0;
+    for (uint32_t i = 0; i < stream_count; i++)
+    {
+        if (!src_len[i])
+            continue;
+        dma_channel_set_read_addr(streams[i].dma_chan, src[i], false);
+        dma_channel_set_trans_count(streams[i].dma_chan, src_len[i], false);
+        start_mask |= 1u << streams[i].dma_chan;
+    }
+
+    if (start_mask)
+    {
+        dma_pending_mask = start_mask;
+        dma_start_channel_mask(start_mask);
+    }
+    back_buffer ^= 1;
+
+    last_push_len = data_len;
+    last_push_time = get_absolute_time();
+    stats.frames_pushed++;
+
+    return true;
+}
+
+led_stats_t led_get_stats() { return stats; }
+
+bool led_push_in_progress()
+{
+    if (dma_pending_mask)
+        return true;
+    __compiler_memory_barrier();
+    return !time_reached(latch_time);
+}
+
+void led_wait_for_push()
+{
+    while (dma_pending_mask)
+        tight_loop_contents();
+    __compiler_memory_barrier();
+    sleep_until(latch_time);
+}
+
+void led_set_push_complete_callback(led_push_complete_callback_t callback) { push_complete_callback = callback; }
+
 void led_shutdown()
 {
-    pio_remove_program_and_unclaim_sm(&ws2812_program, pio, sm, offset);
-    pio = {};
-    sm = {};
-    offset = {};
+    led_wait_for_push();
+
+    for (uint32_t i = 0; i < stream_count; i++)
+    {
+        led_stream_t& stream = streams[i];
+
+        dma_channel_set_irq0_enabled(stream.dma_chan, false);
+        dma_channel_unclaim(stream.dma_chan);
+
+        pio_remove_program_and_unclaim_sm(stream.program, stream.pio, stream.sm, stream.offset);
+
+        for (int j = 0; j < 2; j++)
+            free(stream.staging[j]);
+
+        stream = {};
+    }
+    if (stream_count)
+        irq_remove_handler(DMA_IRQ_0, led_dma_irq_handler);
+    stream_count = 0;
+    latch_delay_us = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        free(planes[i]);
+        planes[i] = NULL;
+    }
+    parallel_strip_count = 0;
+    is_segmented = false;
+    last_push_len = 0;
 }
@@ -33,23 +33,37 @@
 
 /* For size_t */
 #include <stddef.h>
-/* For int8_t */
+/* For uint32_t */
 #include <stdint.h>
 
-struct led_color_t
-{
-    inline led_color_t() { }
-    inline led_color_t(const int8_t _r, const int8_t _g, const int8_t _b) { r = _r, g = _g, b = _b; }
-    inline led_color_t(const int8_t _r, const int8_t _g, const int8_t _b, const int8_t _w) { r = _r, g = _g, b = _b, w = _w; }
-
-    int8_t r = 0;
-    int8_t g = 0;
-    int8_t b = 0;
-    int8_t w = 0;
-};
+#include "config.h"
+
+/**
+ * Pixel stored in the word format @ref ws2812.pio expects
+ *
+ * The byte order is set at compile time by @ref LED_BYTE_POS_R, @ref LED_BYTE_POS_G, @ref LED_BYTE_POS_B, and @ref LED_BYTE_POS_W
+ */
+typedef uint32_t led_pixel_t;
+
+/** Maximum number of strips that led_init_parallel() can drive */
+#define LED_PARALLEL_MAX_STRIPS 8
+
+/** Maximum number of segments that led_init_segments() can drive (4 state machines on each of the 2 PIO blocks) */
+#define LED_MAX_SEGMENTS 8
 
-struct led_swizzle_config_t
+/**
+ * Physical segment of the framebuffer
+ *
+ * Segments are laid out in the framebuffer in the order they are passed to led_init_segments()
+ */
+struct led_segment_config_t
 {
+    /** GPIO pin for datastream output */
+    uint32_t gpio;
+    /** Number of pixels in the segment */
+    uint32_t pixel_count;
+    /** Pixel hardware supports a white color component */
+    bool is_rgbw;
     /** Position of red color component in output datastream */
     int8_t byte_pos_r;
     /** Position of green color component in output datastream */
@@ -60,6 +74,15 @@ struct led_swizzle_config_t
     int8_t byte_pos_w;
 };
 
+/**
+ * Pack color components into a @ref led_pixel_t
+ */
+constexpr led_pixel_t led_pack(const uint8_t r, const uint8_t g, const uint8_t b, const uint8_t w = 0)
+{
+    return (led_pixel_t(r) << (LED_BYTE_POS_R * 8)) | (led_pixel_t(g) << (LED_BYTE_POS_G * 8)) | (led_pixel_t(b) << (LED_BYTE_POS_B * 8))
+        | (led_pixel_t(w) << (LED_BYTE_POS_W * 8));
+}
+
 /**
  * Init led interface
  *
@@ -70,13 +93,103 @@ struct led_swizzle_config_t
 void led_init(const bool is_rgbw, const uint32_t frequency, const uint32_t gpio);
 
 /**
- * Push color data to hardware
+ * Init led interface for driving multiple strips in parallel using @ref ws2812_parallel
+ *
+ * The framebuffer is split evenly between the strips, strip N is driven by `gpio_base + N`
+ *
+ * @param is_rgbw Pixel hardware supports a white color component
+ * @param frequency Datastream frequency
+ * @param gpio_base First GPIO pin to use for datastream output
+ * @param strip_count Number of strips (and consecutive GPIO pins), must be in the range [1, @ref LED_PARALLEL_MAX_STRIPS] and divide @ref LED_PIXEL_COUNT
+ */
+void led_init_parallel(const bool is_rgbw, const uint32_t frequency, const uint32_t gpio_base, const uint32_t strip_count);
+
+/**
+ * Init led interface for driving the framebuffer as multiple segments, each with its own state machine
+ *
+ * All segments are transmitted concurrently, so the refresh time is set by the longest segment.
+ * Segments with a byte order that does not match @ref led_pixel_t are swizzled on every push.
+ *
+ * @param segments Array of segment configs, the pixel counts must add up to @ref LED_PIXEL_COUNT
+ * @param segment_count Number of segments, must be in the range [1, @ref LED_MAX_SEGMENTS]
+ * @param frequency Datastream frequency
+ */
+void led_init_segments(const led_segment_config_t* segments, const size_t segment_count, const uint32_t frequency);
+
+/**
+ * Transpose strips of pixels into the bit planes @ref ws2812_parallel expects
+ *
+ * Each output word holds one bit from every strip, bit N of the word belongs to strip N
+ *
+ * @param strips Array of `strip_count` pointers to pixel data
+ * @param strip_count Number of strips, must not exceed @ref LED_PARALLEL_MAX_STRIPS
+ * @param pixel_count Number of pixels in each strip
+ * @param rgbw Include the lowest byte of each pixel (which non-RGBW strips never receive)
+ * @param out Output array, must hold `pixel_count * (rgbw ? 32 : 24)` words
+ */
+void led_transpose_planes(const led_pixel_t* const* strips, const size_t strip_count, const size_t pixel_count, const bool rgbw, uint32_t* out);
+
+/**
+ * Callback for when a push has been fully read by DMA
+ *
+ * @warning Called from interrupt context
+ */
+typedef void (*led_push_complete_callback_t)();
+
+/**
+ * Get the framebuffer to render the next frame into
+ *
+ * The framebuffer is never the one being read by DMA, so it can be written to while the previous push is transmitted
+ *
+ * @returns Framebuffer with room for @ref LED_PIXEL_COUNT pixels, valid until the next call to led_push_framebuffer()
+ */
+led_pixel_t* led_get_framebuffer();
+
+/**
+ * Push the framebuffer returned by led_get_framebuffer() to hardware
+ *
+ * This only blocks if the previous push is still being transmitted.
+ *
+ * The push is skipped if the framebuffer matches the previous push,
+ * unless @ref LED_FORCED_REFRESH_INTERVAL has passed since the previous push.
+ *
+ * @param data_len Number of pixels to push, must not exceed @ref LED_PIXEL_COUNT
+ *
+ * @returns True if the framebuffer was pushed, false if it was skipped
+ */
+bool led_push_framebuffer(const size_t data_len);
+
+struct led_stats_t
+{
+    /** Number of frames sent to hardware */
+    uint32_t frames_pushed;
+    /** Number of frames skipped because they matched the previous frame */
+    uint32_t frames_skipped;
+};
+
+/**
+ * Get push/skip counters
+ */
+led_stats_t led_get_stats();
+
+/**
+ * Check if a push is still being transmitted
+ *
+ * @returns True if the previous push is still being read by DMA, or if the strip has not yet latched it
+ */
+bool led_push_in_progress();
+
+/**
+ * Block until the previous push has been fully transmitted and latched by the strip
+ */
+void led_wait_for_push();
+
+/**
+ * Set function to be called when DMA has finished reading a push
  *
- * @param data Color data
- * @param data_len Number of pixels (length of color data)
- * @param swizzle_config Config for swizzling color data to a format @ref ws2812.pio expects
+ * @param callback Function to call, or NULL to disable
  */
-void led_push(const led_color_t* data, const size_t data_len, const led_swizzle_config_t& swizzle_config);
+void led_set_push_complete_callback(led_push_complete_callback_t callback);
 
 /**
  * Cleanup resources
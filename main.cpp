@@ -47,13 +47,19 @@
 #include "pico/stdlib.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "config.h"
+#include "core_message.h"
 #include "datetime.h"
 #include "gps.h"
+#include "gps_pps.h"
+#include "gps_rx.h"
 #include "led.h"
 #include "license_text.h"
+#include "schedule.h"
 #include "sunrise.h"
+#include "timezone.h"
 
 #define arraysizeof(array) (sizeof(array) / sizeof(array[0]))
 
@@ -72,17 +78,27 @@ static void verify_time(const datetime_t& a, const datetime_t& b)
  */
 static void check_dst()
 {
-    const timespan_t offset_dt = timespan_t(0, -8, 0, 0);
-    const timespan_t offset_st = timespan_t(0, -9, 0, 0);
+    static timezone_t tz_north;
+    static timezone_t tz_south;
+    static const bool tz_valid = tz_north.parse("AKST9AKDT,M3.2.0,M11.1.0") && tz_south.parse("AEST-10AEDT,M10.1.0,M4.1.0/3");
+    if (!tz_valid)
+        printf("Timezone parse failure\n");
+
     verify_time(datetime_t((1762077599) * MICROSECONDS_PER_SECOND), datetime_t(2025, 11, 2, 9, 59, 59));
     verify_time(datetime_t((1762077600) * MICROSECONDS_PER_SECOND), datetime_t(2025, 11, 2, 10, 0, 0));
-    verify_time(datetime_t((1762077599) * MICROSECONDS_PER_SECOND).get_tz_corrected(offset_st, offset_dt), datetime_t(2025, 11, 2, 1, 59, 59));
-    verify_time(datetime_t((1762077600) * MICROSECONDS_PER_SECOND).get_tz_corrected(offset_st, offset_dt), datetime_t(2025, 11, 2, 1, 0, 0));
+    verify_time(tz_north.to_local(datetime_t((1762077599) * MICROSECONDS_PER_SECOND)), datetime_t(2025, 11, 2, 1, 59, 59));
+    verify_time(tz_north.to_local(datetime_t((1762077600) * MICROSECONDS_PER_SECOND)), datetime_t(2025, 11, 2, 1, 0, 0));
 
     verify_time(datetime_t((1741517999) * MICROSECONDS_PER_SECOND), datetime_t(2025, 3, 9, 10, 59, 59));
     verify_time(datetime_t((1741518000) * MICROSECONDS_PER_SECOND), datetime_t(2025, 3, 9, 11, 0, 0));
-    verify_time(datetime_t((1741517999) * MICROSECONDS_PER_SECOND).get_tz_corrected(offset_st, offset_dt), datetime_t(2025, 3, 9, 1, 59, 59));
-    verify_time(datetime_t((1741518000) * MICROSECONDS_PER_SECOND).get_tz_corrected(offset_st, offset_dt), datetime_t(2025, 3, 9, 3, 0, 0));
+    verify_time(tz_north.to_local(datetime_t((1741517999) * MICROSECONDS_PER_SECOND)), datetime_t(2025, 3, 9, 1, 59, 59));
+    verify_time(tz_north.to_local(datetime_t((1741518000) * MICROSECONDS_PER_SECOND)), datetime_t(2025, 3, 9, 3, 0, 0));
+
+    /* Southern hemisphere: Daylight savings time ends in April and starts in October */
+    verify_time(tz_south.to_local(datetime_t(2025, 4, 5, 15, 59, 59)), datetime_t(2025, 4, 6, 2, 59, 59));
+    verify_time(tz_south.to_local(datetime_t(2025, 4, 5, 16, 0, 0)), datetime_t(2025, 4, 6, 2, 0, 0));
+    verify_time(tz_south.to_local(datetime_t(2025, 10, 4, 15, 59, 59)), datetime_t(2025, 10, 5, 1, 59, 59));
+    verify_time(tz_south.to_local(datetime_t(2025, 10, 4, 16, 0, 0)), datetime_t(2025, 10, 5, 3, 0, 0));
 }
 
 static int status_impl_dummy_func(const char*, va_list) { return 0; }
@@ -101,6 +117,41 @@ static formatting_attribute(1) int status(const char* fmt, ...)
     return r;
 }
 
+/** Last time sync reported by core 1 */
+static core_message_time_sync_t last_time_sync = {};
+
+/**
+ * Handle all messages waiting from core 1
+ */
+static void handle_core_messages()
+{
+    /* Too big for the stack */
+    static core_message_t msg;
+
+    while (core_message_receive(msg))
+    {
+        switch (msg.type)
+        {
+        case CORE_MESSAGE_TIME_SYNC:
+            last_time_sync = msg.time_sync;
+            break;
+        case CORE_MESSAGE_FIX_CHANGED:
+            printf("GPS fix changed: Status %ld, mode %ld, %ld satellites used\n", msg.fix_changed.fix_status, msg.fix_changed.fix_mode,
+                msg.fix_changed.satellites_used);
+            break;
+        case CORE_MESSAGE_FIRMWARE_INFO:
+        {
+            const char* release_str = msg.firmware_info;
+            const char* build_id = release_str + strlen(release_str) + 1;
+            const char* internal_1 = build_id + strlen(build_id) + 1;
+            const char* internal_2 = internal_1 + strlen(internal_1) + 1;
+            printf("GPS firmware: %s, build id: %s, internal: %s %s\n", release_str, build_id, internal_1, internal_2);
+            break;
+        }
+        }
+    }
+}
+
 int main()
 {
     watchdog_enable(WATCHDOG_INIT_TIME, 1);
@@ -109,20 +160,54 @@ int main()
 
     stdio_init_all();
 
-    const timespan_t offset_dt = TIMEZONE_OFFSET_DT;
-    const timespan_t offset_st = TIMEZONE_OFFSET_ST;
+    static timezone_t local_timezone;
+    const bool timezone_valid = local_timezone.parse(TIMEZONE_RULES);
+    hard_assert(timezone_valid);
 
     /* Reset to midnight 1970-1-11 (local time zone) */
-    set_unix_time(MICROSECONDS_PER_DAY * 10 - offset_st.to_microseconds_since_1970());
+    set_unix_time(MICROSECONDS_PER_DAY * 10 - local_timezone.get_std_offset().to_microseconds_since_1970());
 
+#if LED_SEGMENT_COUNT > 0
+    static const led_segment_config_t led_segments[LED_SEGMENT_COUNT] = { LED_SEGMENTS };
+    led_init_segments(led_segments, LED_SEGMENT_COUNT, LED_FREQUENCY);
+#elif LED_PARALLEL_STRIP_COUNT > 1
+    led_init_parallel(LED_IS_RGBW, LED_FREQUENCY, LED_GPIO, LED_PARALLEL_STRIP_COUNT);
+#else
     led_init(LED_IS_RGBW, LED_FREQUENCY, LED_GPIO);
+#endif
+
+    sunrise_init(LED_WHITE_COLOR_TEMP);
 
 #if SUNRISE_TESTING == 0
     multicore_launch_core1(gps_thread_func);
 #endif
 
+#if SUNRISE_TESTING
+    /* start, full_power, off_allowed, off_forced */
+    const schedule_config_t schedule_config = {
+        timespan_t(0, 0, 0, 10),
+        timespan_t(0, 0, 1, 10),
+        timespan_t(0, 0, 1, 20),
+        timespan_t(0, 0, 1, 30),
+    };
+#else
+    /* start, full_power, off_allowed, off_forced */
+    const schedule_config_t schedule_config = {
+        timespan_t(0, 5, 30, 0),
+        timespan_t(0, 6, 0, 0),
+        timespan_t(0, 7, 0, 0),
+        timespan_t(0, 7, 30, 0),
+    };
+#endif
+    static schedule_t schedule(local_timezone, schedule_config);
+
     uint64_t last_status_time = 0;
+
+    /* Too big for the stack */
+    static gps_snapshot_t gps = {};
     loop_measure_t perf = {};
+    /** Total time the main loop has spent asleep */
+    uint64_t idle_time = 0;
 
     watchdog_disable();
     watchdog_enable(WATCHDOG_LOOP_TIME, 1);
@@ -130,7 +215,7 @@ int main()
     while (true)
     {
 #if SUNRISE_TESTING == 0
-        if (!time_reached(gps_data.watchdog_expiry_time))
+        if (!time_reached(gps_get_watchdog_expiry_time()))
             watchdog_update();
 #else
         watchdog_update();
@@ -147,28 +232,8 @@ int main()
 
         check_dst();
 
-        const datetime_t now = datetime_t::get_current_utc().get_tz_corrected(offset_st, offset_dt);
-        const datetime_t midnight = datetime_t(now.year, now.month, now.day);
-
-#if SUNRISE_TESTING
-        // Negative offset from full_power_time
-        const timespan_t rise_time = timespan_t(0, 0, 1, 0);
-
-        // Positive offsets from midnight
-        const datetime_t full_power_time = midnight + rise_time + timespan_t(0, 0, 0, 10);
-        const datetime_t start_time = full_power_time - rise_time;
-        const datetime_t off_allowed_time = full_power_time + timespan_t(0, 0, 0, 10);
-        const datetime_t off_forced_time = off_allowed_time + timespan_t(0, 0, 0, 10);
-#else
-        // Negative offset from full_power_time
-        const timespan_t rise_time = timespan_t(0, 0, 30, 0);
-
-        // Positive offsets from midnight
-        const datetime_t full_power_time = midnight + timespan_t(0, 6, 0, 0);
-        const datetime_t start_time = full_power_time - rise_time;
-        const datetime_t off_allowed_time = midnight + timespan_t(0, 7, 0, 0);
-        const datetime_t off_forced_time = midnight + timespan_t(0, 7, 30, 0);
-#endif
+        const microseconds_t now = get_unix_time();
+        schedule.update(now);
 
         char buf[64];
 
@@ -181,56 +246,137 @@ int main()
         status("\n======> License text (pico-sdk and pico-examples)\n");
         status("%s", license_text_pico_sdk_and_pico_examples);
 
+        handle_core_messages();
+
+        if (status_impl != status_impl_dummy_func)
+            gps_update_snapshot(gps);
+
         status("\n======> GPS Status\n");
-        status("Firmware release:    %s\n", gps_data.firmware_release_str);
-        status("Firmware build id:   %s\n", gps_data.firmware_build_id);
-        status("Firmware internal 1: %s\n", gps_data.firmware_internal_1);
-        status("Firmware internal 2: %s\n", gps_data.firmware_internal_2);
-        status("Avg. loop time:   %lld us\n", gps_data.perf.average_loop_time);
-        status("loops_per_second: %.3f\n", gps_data.perf.loops_per_second);
-        status("Satellites used:  %d\n", gps_data.satellites_used);
-        status("Fix status:       %d\n", gps_data.fix_status);
-        status("NMEA Parsing: %s\n", gps_data.nmea_in_progress);
-        status("NMEA Last:    %s\n", gps_data.nmea_last_full);
-
-        float sunrise_factor = -1.0;
-
-        if (start_time <= now && now < full_power_time)
+        status("Firmware release:    %s\n", gps.firmware.release_str);
+        status("Firmware build id:   %s\n", gps.firmware.build_id);
+        status("Firmware internal 1: %s\n", gps.firmware.internal_1);
+        status("Firmware internal 2: %s\n", gps.firmware.internal_2);
+        status("Avg. loop time:   %lld us\n", gps.stats.average_loop_time);
+        status("loops_per_second: %.3f\n", gps.stats.loops_per_second);
+        status("Satellites used:  %ld\n", gps.fix.satellites_used);
+        status("Fix status:       %d, mode %ld\n", gps.fix.fix_status, gps.fix.fix_mode);
+        status("Position:         %.7f, %.7f (%s)\n", gps.fix.latitude / 1e7, gps.fix.longitude / 1e7, gps.fix.rmc_valid ? "Valid" : "Invalid");
+        status("Altitude:         %.1f m\n", gps.fix.altitude / 10.0);
+        status("DOP (P/H/V):      %.2f/%.2f/%.2f\n", gps.fix.pdop / 100.0, gps.fix.hdop / 100.0, gps.fix.vdop / 100.0);
+        status("Last ack:         PMTK%03ld -> %ld (%lu failed)\n", gps.stats.last_ack_command, gps.stats.last_ack_flag, gps.stats.failed_acks);
+        const gps_rx_stats_t gps_rx_stats = gps_rx_get_stats();
+        status("RX bytes:         %lu\n", gps_rx_stats.bytes_received);
+        status("RX high water:    %lu/%d\n", gps_rx_stats.high_water_mark, GPS_RX_BUFFER_SIZE);
+        status("RX ring overruns: %lu\n", gps_rx_stats.ring_overruns);
+        status("RX FIFO overruns: %lu\n", gps_rx_stats.fifo_overruns);
+        status("Time syncs:       %lu (%lu PPS, %lu skipped)\n", gps.stats.sync.count, gps.stats.sync.pps_count, gps.stats.sync.skipped);
+        status("PPS pulses:       %lu\n", gps_pps_get_count());
+        status("Sync residual:    %lld us\n", gps.stats.sync.residual);
+        status("Sync parse delay: %lld us\n", gps.stats.sync.parse_delay);
+        const gps_parser_stats_t parser_stats = gps.stats.parser;
+        status("NMEA sentences:   %lu\n", parser_stats.sentences);
+        status("NMEA csum errors: %lu\n", parser_stats.checksum_errors);
+        status("NMEA overflows:   %lu\n", parser_stats.overflows);
+        status("NMEA framing err: %lu\n", parser_stats.framing_errors);
+        status("NMEA unhandled:   %lu\n", parser_stats.unhandled);
+        if (parser_stats.parse_time)
+            status("NMEA parse speed: %llu bytes/s\n", uint64_t(parser_stats.bytes) * 1000000 / parser_stats.parse_time);
+        status("NMEA Last:    %s\n", gps.nmea_last_full.sentence);
+
+        const unix_time_stats_t clock_stats = get_unix_time_stats();
+        status("\n======> Clock status\n");
+        status("Synced:           %s\n", clock_stats.synced ? "Yes" : "No");
+        status("Since last sync:  %llu ms\n", (time_us_64() - clock_stats.last_sync) / 1000);
+        status("Freq. correction: %.3f ppm\n", clock_stats.frequency_ppm);
+        status("Phase error:      %lld us\n", clock_stats.phase_error);
+        status("Slew remaining:   %lld us\n", clock_stats.slew_remaining);
+        status("Syncs:            %lu\n", clock_stats.syncs);
+        status("Steps:            %lu\n", clock_stats.steps);
+        status("Rejections:       %lu\n", clock_stats.rejections);
+        status("Last sync:        %s (%s, %lld us)\n", datetime_t(last_time_sync.unix_time).print_to_buffer(buf, arraysizeof(buf)),
+            last_time_sync.pps ? "PPS" : "NMEA", last_time_sync.phase_error);
+        const core_message_stats_t message_stats = core_message_get_stats();
+        status("Messages:         %lu posted, %lu received, %lu dropped, max depth %lu\n", message_stats.posted, message_stats.received,
+            message_stats.dropped, message_stats.max_depth);
+        if (status_impl != status_impl_dummy_func)
         {
-            double time_elapsed = now.to_microseconds_since_1970() - start_time.to_microseconds_since_1970();
-            double time_to_full = full_power_time.to_microseconds_since_1970() - start_time.to_microseconds_since_1970();
-            sunrise_factor = time_elapsed / time_to_full;
+            /* Measure read latency in place, with core 1 running (and syncing), averaged since a single read takes under 1 us */
+            const uint32_t clock_read_start = time_us_32();
+            for (int i = 0; i < 256; i++)
+                get_unix_time();
+            status("Read latency:     %lu ns\n", (time_us_32() - clock_read_start) * 1000 / 256);
         }
-        if (full_power_time <= now && now < off_forced_time)
-            sunrise_factor = 1.0;
+
+        const int32_t sunrise_factor = schedule.get_sunrise_factor(now);
 
         status("\n======> Sunrise status\n");
-        status("Current time:     %s\n", now.print_to_buffer(buf, arraysizeof(buf)));
-        status("Midnight:         %s\n", midnight.print_to_buffer(buf, arraysizeof(buf)));
-        status("start_time:       %s\n", start_time.print_to_buffer(buf, arraysizeof(buf)));
-        status("full_power_time:  %s\n", full_power_time.print_to_buffer(buf, arraysizeof(buf)));
-        status("off_allowed_time: %s\n", off_allowed_time.print_to_buffer(buf, arraysizeof(buf)));
-        status("off_forced_time:  %s\n", off_forced_time.print_to_buffer(buf, arraysizeof(buf)));
-        status("sunrise_factor:   %f\n", sunrise_factor);
+        if (status_impl != status_impl_dummy_func)
+        {
+            static const char* const event_labels[SCHEDULE_EVENT_COUNT] = {
+                "start_time:       ",
+                "full_power_time:  ",
+                "off_allowed_time: ",
+                "off_forced_time:  ",
+                "Next midnight:    ",
+            };
+            status("Current time:     %s %s\n", local_timezone.to_local(datetime_t(now)).print_to_buffer(buf, arraysizeof(buf)),
+                local_timezone.get_name(datetime_t(now)));
+            status("Midnight:         %s\n", local_timezone.to_local(datetime_t(schedule.get_day_start())).print_to_buffer(buf, arraysizeof(buf)));
+            for (int i = 0; i < SCHEDULE_EVENT_COUNT; i++)
+            {
+                const datetime_t event_time = datetime_t(schedule.get_event_time(schedule_event_type_t(i)));
+                status("%s%s\n", event_labels[i], local_timezone.to_local(event_time).print_to_buffer(buf, arraysizeof(buf)));
+            }
+            status("Next event:       %s in %lld s\n", schedule_event_name(schedule.get_next_event().type),
+                schedule.time_until_next_event(now) / MICROSECONDS_PER_SECOND);
+            status("Recomputes:       %lu\n", schedule.get_recompute_count());
+        }
+        status("sunrise_factor:   %ld/%d\n", sunrise_factor, SUNRISE_FACTOR_ONE);
         status("Avg. loop time:   %lld us\n", perf.average_loop_time);
         status("loops_per_second: %.3f\n", perf.loops_per_second);
+        status("Idle time:        %.1f%%\n", idle_time * 100.0 / loop_start_time);
 
-        led_color_t* colors = (led_color_t*)calloc(LED_PIXEL_COUNT, sizeof(led_color_t));
+        const uint32_t render_start_time = time_us_32();
+        sunrise_apply(sunrise_factor, led_get_framebuffer(), LED_PIXEL_COUNT);
+        const uint32_t render_time = time_us_32() - render_start_time;
 
-        sunrise_apply(sunrise_factor, LED_WHITE_COLOR_TEMP, colors, LED_PIXEL_COUNT);
+        led_push_framebuffer(LED_PIXEL_COUNT);
 
-        led_swizzle_config_t led_config = {};
-        led_config.byte_pos_r = LED_BYTE_POS_R;
-        led_config.byte_pos_g = LED_BYTE_POS_G;
-        led_config.byte_pos_b = LED_BYTE_POS_B;
-        led_config.byte_pos_w = LED_BYTE_POS_W;
+        const led_stats_t led_stats = led_get_stats();
+        status("\n======> LED status\n");
+        status("Frames pushed:    %lu\n", led_stats.frames_pushed);
+        status("Frames skipped:   %lu\n", led_stats.frames_skipped);
+        status("Render time:      %lu us\n", render_time);
 
-        led_push(colors, LED_PIXEL_COUNT, led_config);
-
-        free(colors);
+        const sunrise_stats_t sunrise_stats = sunrise_get_stats();
+        status("Cache hits:       %lu\n", sunrise_stats.cache_hits);
+        status("Cache misses:     %lu\n", sunrise_stats.cache_misses);
 
         perf.end_loop();
-        sleep_ms(1);
+
+        /* Sleep until something has to be done, the watchdog must still be fed well within WATCHDOG_LOOP_TIME */
+        uint64_t wake_time = loop_start_time + WATCHDOG_LOOP_TIME * 1000 / 2;
+        const uint64_t next_status_time = (loop_start_time / STATUS_PRINT_INTERVAL + 1) * STATUS_PRINT_INTERVAL;
+        if (next_status_time < wake_time)
+            wake_time = next_status_time;
+        if (loop_start_time + LED_FORCED_REFRESH_INTERVAL < wake_time)
+            wake_time = loop_start_time + LED_FORCED_REFRESH_INTERVAL;
+        if (sunrise_factor >= 0 && sunrise_factor < SUNRISE_FACTOR_ONE && loop_start_time + LED_FRAME_INTERVAL < wake_time)
+            wake_time = loop_start_time + LED_FRAME_INTERVAL;
+
+        const uint64_t sleep_start_time = time_us_64();
+        const uint64_t next_event_time = sleep_start_time + schedule.time_until_next_event(get_unix_time());
+        if (next_event_time < wake_time)
+            wake_time = next_event_time;
+
+        /*
+         * The timeout is a hardware alarm, and core 1 sets an event whenever it posts a message.
+         * Other events (eg. the GPS UART interrupt on core 1) are slept through.
+         */
+        while (!core_message_pending() && !best_effort_wfe_or_timeout(from_us_since_boot(wake_time)))
+        {
+        }
+        idle_time += time_us_64() - sleep_start_time;
     }
 
     led_shutdown();
@@ -0,0 +1,122 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Lock-free single producer single consumer ring buffer
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hardware/sync.h"
+
+/**
+ * Lock-free single producer single consumer ring buffer
+ *
+ * Safe to use between an interrupt handler and thread code, or between the two cores,
+ * as long as there is only one producer and one consumer.
+ *
+ * Struct must be zero-initialized
+ *
+ * @tparam T Element type
+ * @tparam N Capacity, must be a power of two
+ */
+template <typename T, uint32_t N> struct spsc_ring_t
+{
+    static_assert(N && (N & (N - 1)) == 0, "Ring buffer capacity must be a power of two");
+
+    /**
+     * Push an element (Producer only)
+     *
+     * @returns False if the ring is full
+     */
+    bool push(const T& val)
+    {
+        const uint32_t h = head;
+        if (h - tail == N)
+            return false;
+        data[h & (N - 1)] = val;
+        __dmb();
+        head = h + 1;
+        return true;
+    }
+
+    /**
+     * Push `len` elements, or none if they do not all fit (Producer only)
+     *
+     * @returns False if there was not enough space
+     */
+    bool push(const T* vals, const size_t len)
+    {
+        const uint32_t h = head;
+        if (N - (h - tail) < len)
+            return false;
+        for (size_t i = 0; i < len; i++)
+            data[(h + i) & (N - 1)] = vals[i];
+        __dmb();
+        head = h + len;
+        return true;
+    }
+
+    /**
+     * Pop up to `max_len` elements (Consumer only)
+     *
+     * @returns Number of elements copied to `out`
+     */
+    size_t pop(T* out, const size_t max_len)
+    {
+        const uint32_t t = tail;
+        uint32_t avail = head - t;
+        __dmb();
+        if (avail > max_len)
+            avail = max_len;
+        for (uint32_t i = 0; i < avail; i++)
+            out[i] = data[(t + i) & (N - 1)];
+        __dmb();
+        tail = t + avail;
+        return avail;
+    }
+
+    /**
+     * Get number of elements in the ring (Approximate unless called by the producer or consumer)
+     */
+    uint32_t size() const { return head - tail; }
+
+    /**
+     * Get number of elements that can be pushed before the ring is full (Approximate unless called by the producer or consumer)
+     */
+    uint32_t space() const { return N - size(); }
+
+    /** Free running write counter, only written by the producer */
+    volatile uint32_t head;
+    /** Free running read counter, only written by the consumer */
+    volatile uint32_t tail;
+
+    T data[N];
+};
@@ -0,0 +1,123 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Daily sunrise schedule (Implementation)
+ */
+#include "schedule.h"
+
+#include "sunrise.h"
+
+#include "pico.h"
+
+const char* schedule_event_name(const schedule_event_type_t type)
+{
+    switch (type)
+    {
+    case SCHEDULE_EVENT_START:
+        return "start";
+    case SCHEDULE_EVENT_FULL_POWER:
+        return "full_power";
+    case SCHEDULE_EVENT_OFF_ALLOWED:
+        return "off_allowed";
+    case SCHEDULE_EVENT_OFF_FORCED:
+        return "off_forced";
+    case SCHEDULE_EVENT_MIDNIGHT:
+        return "midnight";
+    default:
+        return "unknown";
+    }
+}
+
+schedule_t::schedule_t(const timezone_t& _tz, const schedule_config_t& _config)
+    : tz(_tz)
+    , config(_config)
+{
+    const timespan_t offsets[] = { config.start, config.full_power, config.off_allowed, config.off_forced };
+    for (const timespan_t& offset : offsets)
+        hard_assert(offset >= timespan_t(0) && offset < timespan_t(1, 0, 0, 0));
+}
+
+void schedule_t::recompute(const microseconds_t utc)
+{
+    const datetime_t midnight = tz.to_local(datetime_t(utc)).get_midnight();
+
+    /* Clamped, in case midnight itself is skipped by a daylight savings transition */
+    day_start = tz.to_utc(midnight).to_microseconds_since_1970();
+    if (day_start > utc)
+        day_start = utc;
+
+    event_times[SCHEDULE_EVENT_START] = tz.to_utc(midnight + config.start).to_microseconds_since_1970();
+    event_times[SCHEDULE_EVENT_FULL_POWER] = tz.to_utc(midnight + config.full_power).to_microseconds_since_1970();
+    event_times[SCHEDULE_EVENT_OFF_ALLOWED] = tz.to_utc(midnight + config.off_allowed).to_microseconds_since_1970();
+    event_times[SCHEDULE_EVENT_OFF_FORCED] = tz.to_utc(midnight + config.off_forced).to_microseconds_since_1970();
+    event_times[SCHEDULE_EVENT_MIDNIGHT] = tz.to_utc(midnight + timespan_t(1, 0, 0, 0)).to_microseconds_since_1970();
+
+    /* Insertion sort, the list is tiny and usually already sorted */
+    for (uint32_t i = 0; i < SCHEDULE_EVENT_COUNT; i++)
+    {
+        schedule_event_t event = { event_times[i], schedule_event_type_t(i) };
+        uint32_t j = i;
+        for (; j > 0 && events[j - 1].time > event.time; j--)
+            events[j] = events[j - 1];
+        events[j] = event;
+    }
+
+    recompute_count++;
+}
+
+bool schedule_t::update(const microseconds_t utc)
+{
+    /* Fast path: No event has passed since the last update */
+    if (prev_event_time <= utc && utc < events[next_event].time)
+        return false;
+
+    const bool recomputed = utc < day_start || utc >= event_times[SCHEDULE_EVENT_MIDNIGHT];
+    if (recomputed)
+        recompute(utc);
+
+    next_event = 0;
+    prev_event_time = day_start;
+    while (next_event < SCHEDULE_EVENT_COUNT - 1 && events[next_event].time <= utc)
+        prev_event_time = events[next_event++].time;
+
+    return recomputed;
+}
+
+int32_t schedule_t::get_sunrise_factor(const microseconds_t utc) const
+{
+    const microseconds_t start = event_times[SCHEDULE_EVENT_START];
+    const microseconds_t full_power = event_times[SCHEDULE_EVENT_FULL_POWER];
+
+    if (start <= utc && utc < full_power)
+        return ((utc - start) * SUNRISE_FACTOR_ONE) / (full_power - start);
+    if (full_power <= utc && utc < event_times[SCHEDULE_EVENT_OFF_FORCED])
+        return SUNRISE_FACTOR_ONE;
+
+    return -1;
+}
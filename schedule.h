@@ -0,0 +1,161 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Daily sunrise schedule
+ */
+#pragma once
+
+#include "datetime.h"
+#include "timezone.h"
+
+enum schedule_event_type_t : uint8_t
+{
+    /** Sunrise starts fading in */
+    SCHEDULE_EVENT_START,
+    /** Sunrise reaches full power */
+    SCHEDULE_EVENT_FULL_POWER,
+    /** Sunrise may be turned off */
+    SCHEDULE_EVENT_OFF_ALLOWED,
+    /** Sunrise is turned off */
+    SCHEDULE_EVENT_OFF_FORCED,
+    /** Local midnight at the end of the day, the schedule is recomputed when it passes */
+    SCHEDULE_EVENT_MIDNIGHT,
+
+    SCHEDULE_EVENT_COUNT,
+};
+
+/**
+ * Get name of an event type
+ */
+const char* schedule_event_name(const schedule_event_type_t type);
+
+struct schedule_event_t
+{
+    /** UTC microseconds since 1970 */
+    microseconds_t time;
+    schedule_event_type_t type;
+};
+
+/**
+ * Times of the daily events, as local time offsets from midnight
+ */
+struct schedule_config_t
+{
+    timespan_t start;
+    timespan_t full_power;
+    timespan_t off_allowed;
+    timespan_t off_forced;
+};
+
+/**
+ * Event times of the current local day, computed once per day
+ *
+ * Events are stored in UTC and sorted, so that checking the time against them is a single comparison
+ */
+struct schedule_t
+{
+    /**
+     * All event offsets must be in the range [0,24) hours
+     *
+     * @param tz Timezone of the schedule, must outlive the schedule
+     * @param config Local times of the daily events
+     */
+    schedule_t(const timezone_t& tz, const schedule_config_t& config);
+
+    /**
+     * Advance the schedule to a point in time
+     *
+     * The events are recomputed when `utc` leaves the current local day, be it from midnight passing or from the clock being stepped
+     *
+     * @param utc Current UTC time
+     *
+     * @returns True if the events were recomputed
+     */
+    bool update(const microseconds_t utc);
+
+    /**
+     * Get time of an event in the current day
+     *
+     * @returns UTC microseconds since 1970
+     */
+    inline microseconds_t get_event_time(const schedule_event_type_t type) const { return event_times[type]; }
+
+    /**
+     * Get local midnight at the start of the current day
+     *
+     * @returns UTC microseconds since 1970
+     */
+    inline microseconds_t get_day_start() const { return day_start; }
+
+    /**
+     * Get the next event that has not yet passed as of the last call to update()
+     */
+    inline const schedule_event_t& get_next_event() const { return events[next_event]; }
+
+    /**
+     * Get time until the next event that has not yet passed as of the last call to update()
+     *
+     * @param utc Current UTC time
+     *
+     * @returns Microseconds until the next event (Never negative)
+     */
+    inline microseconds_t time_until_next_event(const microseconds_t utc) const
+    {
+        const microseconds_t r = events[next_event].time - utc;
+        return r > 0 ? r : 0;
+    }
+
+    /**
+     * Get sunrise factor for a point in time of the current day
+     *
+     * @returns Value for sunrise_apply()
+     */
+    int32_t get_sunrise_factor(const microseconds_t utc) const;
+
+    /**
+     * Number of times the events have been recomputed
+     */
+    inline uint32_t get_recompute_count() const { return recompute_count; }
+
+private:
+    void recompute(const microseconds_t utc);
+
+    const timezone_t& tz;
+    const schedule_config_t config;
+
+    microseconds_t day_start = 0;
+    /** Time of the event before `next_event` (Or `day_start`) */
+    microseconds_t prev_event_time = 0;
+    microseconds_t event_times[SCHEDULE_EVENT_COUNT] = {};
+    /** Sorted by time, ending with @ref SCHEDULE_EVENT_MIDNIGHT */
+    schedule_event_t events[SCHEDULE_EVENT_COUNT] = {};
+    /** Index into `events` of the first event that has not yet passed */
+    uint32_t next_event = 0;
+    uint32_t recompute_count = 0;
+};
@@ -0,0 +1,121 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Sequence lock for publishing data between cores
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "hardware/sync.h"
+
+/**
+ * Sequence lock
+ *
+ * Readers never block and never delay the writer, instead they retry if the data changed while it was being copied.
+ * Suited to small structs that are read much more often than they are written.
+ *
+ * @warning Writers must be serialized by the caller
+ *
+ * Struct must be zero-initialized
+ *
+ * @tparam T Data type, must be trivially copyable
+ */
+template <typename T> struct seqlock_t
+{
+    /**
+     * Publish new data
+     */
+    void write(const T& val)
+    {
+        write_begin() = val;
+        write_end();
+    }
+
+    /**
+     * Start modifying the data in place, for when only part of a large struct needs to be written
+     *
+     * @returns Reference to the data, valid until write_end()
+     */
+    T& write_begin()
+    {
+        sequence = sequence + 1;
+        __dmb();
+        return data;
+    }
+
+    /**
+     * Finish modifying the data in place
+     */
+    void write_end()
+    {
+        __dmb();
+        sequence = sequence + 1;
+    }
+
+    /**
+     * Get a consistent copy of the data
+     *
+     * @param out Destination for the copy
+     *
+     * @returns Sequence number of the copied data
+     */
+    uint32_t read(T& out) const
+    {
+        uint32_t seq;
+        do
+        {
+            seq = sequence;
+            __dmb();
+            out = data;
+            __dmb();
+        } while ((seq & 1) || seq != sequence);
+        return seq;
+    }
+
+    /**
+     * Get a consistent copy of the data
+     */
+    T read() const
+    {
+        T r;
+        read(r);
+        return r;
+    }
+
+    /**
+     * Get the sequence number, it changes every time the data is written
+     */
+    uint32_t get_sequence() const { return sequence; }
+
+private:
+    /** Odd while a write is in progress */
+    volatile uint32_t sequence;
+    T data;
+};
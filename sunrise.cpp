@@ -32,164 +32,248 @@
 #include "sunrise.h"
 
 #include "config.h"
+#include "gradient.h"
+#include "sunrise_keyframes.h"
 
-#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
-#define PI 3.141592653589793238462643383279502884f
 #define _min(x, y) (((x) < (y)) ? (x) : (y))
-#define _max(x, y) (((x) > (y)) ? (x) : (y))
-#define _mix(x, y, a) ((x) * (1.f - (a)) + (y) * (a))
 #define _clamp(x, a, b) (((x) < (a)) ? (a) : (((x) > (b)) ? (b) : (x)))
 
-struct vec3_t
-{
-    inline vec3_t() { }
-    inline vec3_t(const float _r, const float _g, const float _b) { r = _r, g = _g, b = _b; }
-
-    float r = 0.f;
-    float g = 0.f;
-    float b = 0.f;
+/** Fixed point representation of 1.0 with 16 fractional bits */
+#define Q16_ONE (uint32_t(1) << 16)
 
-    vec3_t operator+(const vec3_t& rhs) const { return { r + rhs.r, g + rhs.g, b + rhs.b }; }
-    vec3_t operator*(const float& rhs) const { return { r * rhs, g * rhs, b * rhs }; }
+/** Q8.8 representation of full brightness for a color component (255.0) */
+#define Q8_FULL (uint32_t(255) << 8)
 
-    vec3_t& operator*=(const float& rhs)
-    {
-        r *= rhs, g *= rhs, b *= rhs;
-        return *this;
-    }
-
-    inline void clamp(const float min, const float max)
-    {
-        r = _clamp(r, min, max);
-        g = _clamp(g, min, max);
-        b = _clamp(b, min, max);
-    }
-};
+/**
+ * Number of low bits dropped from sunrise_factor to form the render cache key
+ *
+ * The steepest part of the sunrise is the brightness ramp, which goes from 0 to 255 while sunrise_factor goes from 0 to 0.5.
+ * That is one 8-bit step per 128 (1 << 7) Q16 units, so keys 64 (1 << 6) units apart keep the error below half a step.
+ */
+#define SUNRISE_CACHE_SHIFT 6
 
-struct vec4_t
+/**
+ * RGB color with Q8.8 components in the range [0, @ref Q8_FULL]
+ */
+struct rgb_q8_t
 {
-    inline vec4_t() { }
-    inline vec4_t(const float _r, const float _g, const float _b) { r = _r, g = _g, b = _b; }
-    inline vec4_t(const float _r, const float _g, const float _b, const float _w) { r = _r, g = _g, b = _b, w = _w; }
-
-    float r = 0.f;
-    float g = 0.f;
-    float b = 0.f;
-    float w = 0.f;
+    uint32_t r;
+    uint32_t g;
+    uint32_t b;
+};
 
-    vec4_t operator+(const vec4_t& rhs) const { return { r + rhs.r, g + rhs.g, b + rhs.b, w + rhs.w }; }
-    vec4_t operator*(const float& rhs) const { return { r * rhs, g * rhs, b * rhs, w * rhs }; }
+// Python script to generate this table
+// #!/bin/python3
+// import sys
+// import math
+//
+// def tanner_helland(temp):
+//     temp /= 100.0
+//     r = 255.0 if temp <= 66 else 329.698727446 * (temp - 60) ** -0.1332047592
+//     g = 99.4708025861 * math.log(temp) - 161.1195681661 if temp <= 66 else 288.1221695283 * (temp - 60) ** -0.0755148492
+//     if temp >= 66:
+//         b = 255.0
+//     elif temp <= 19:
+//         b = 0.0
+//     else:
+//         b = 138.5177312231 * math.log(temp - 10) - 305.0447927307
+//     return [round(min(max(c, 0.0), 255.0) * 256) for c in (r, g, b)]
+//
+// entries = [tanner_helland(k) for k in range(500, 10001, 100)]
+//
+// # Dump source
+// with open(sys.modules[__name__].__file__, "r") as fd:
+//     print("// Python script to generate this table")
+//     for i in fd:
+//         print(f"// {i}", end="")
+//
+// # Dump array
+// print("static const uint16_t kelvin_table[][3] = {")
+// for line in [entries[i:i+6] for i in range(0, len(entries), 6)]:
+//     print("    " + " ".join(f"{{ {r}, {g}, {b} }}," for r, g, b in line))
+// print("};")
+static const uint16_t kelvin_table[][3] = {
+    { 65280, 0, 0 }, { 65280, 4380, 0 }, { 65280, 8305, 0 }, { 65280, 11705, 0 }, { 65280, 14705, 0 }, { 65280, 17388, 0 },
+    { 65280, 19815, 0 }, { 65280, 22030, 0 }, { 65280, 24069, 0 }, { 65280, 25956, 0 }, { 65280, 27713, 0 }, { 65280, 29356, 0 },
+    { 65280, 30900, 0 }, { 65280, 32355, 0 }, { 65280, 33732, 0 }, { 65280, 35038, 3559 }, { 65280, 36281, 6939 }, { 65280, 37465, 10025 },
+    { 65280, 38597, 12863 }, { 65280, 39681, 15491 }, { 65280, 40721, 17937 }, { 65280, 41719, 20226 }, { 65280, 42680, 22376 }, { 65280, 43606, 24403 },
+    { 65280, 44500, 26320 }, { 65280, 45363, 28139 }, { 65280, 46198, 29869 }, { 65280, 47007, 31519 }, { 65280, 47790, 33095 }, { 65280, 48550, 34604 },
+    { 65280, 49289, 36052 }, { 65280, 50006, 37442 }, { 65280, 50704, 38781 }, { 65280, 51383, 40070 }, { 65280, 52044, 41315 }, { 65280, 52689, 42517 },
+    { 65280, 53318, 43680 }, { 65280, 53931, 44805 }, { 65280, 54531, 45897 }, { 65280, 55116, 46955 }, { 65280, 55688, 47983 }, { 65280, 56248, 48982 },
+    { 65280, 56796, 49954 }, { 65280, 57332, 50899 }, { 65280, 57857, 51820 }, { 65280, 58371, 52718 }, { 65280, 58875, 53594 }, { 65280, 59370, 54448 },
+    { 65280, 59855, 55283 }, { 65280, 60331, 56098 }, { 65280, 60798, 56895 }, { 65280, 61257, 57674 }, { 65280, 61708, 58437 }, { 65280, 62151, 59183 },
+    { 65280, 62586, 59915 }, { 65280, 63014, 60631 }, { 65280, 63435, 61333 }, { 65280, 63849, 62022 }, { 65280, 64256, 62697 }, { 65280, 64657, 63360 },
+    { 65280, 65052, 64011 }, { 65280, 65280, 65280 }, { 65131, 63679, 65280 }, { 63983, 63041, 65280 }, { 62987, 62482, 65280 }, { 62109, 61987, 65280 },
+    { 61325, 61543, 65280 }, { 60618, 61140, 65280 }, { 59976, 60771, 65280 }, { 59386, 60432, 65280 }, { 58843, 60118, 65280 }, { 58340, 59826, 65280 },
+    { 57870, 59552, 65280 }, { 57431, 59296, 65280 }, { 57019, 59054, 65280 }, { 56631, 58826, 65280 }, { 56264, 58610, 65280 }, { 55917, 58404, 65280 },
+    { 55586, 58208, 65280 }, { 55272, 58022, 65280 }, { 54972, 57843, 65280 }, { 54686, 57672, 65280 }, { 54412, 57508, 65280 }, { 54149, 57350, 65280 },
+    { 53896, 57198, 65280 }, { 53653, 57052, 65280 }, { 53420, 56911, 65280 }, { 53194, 56775, 65280 }, { 52977, 56643, 65280 }, { 52766, 56515, 65280 },
+    { 52563, 56392, 65280 }, { 52366, 56272, 65280 }, { 52175, 56156, 65280 }, { 51990, 56043, 65280 }, { 51811, 55933, 65280 }, { 51636, 55826, 65280 },
+};
 
-    vec4_t& operator*=(const float& f)
-    {
-        r *= f, g *= f, b *= f, w *= f;
-        return *this;
-    }
+/** Color temperature (in kelvin) of the first entry in `kelvin_table` */
+#define KELVIN_TABLE_MIN 500
+/** Color temperature (in kelvin) of the last entry in `kelvin_table` */
+#define KELVIN_TABLE_MAX 10000
+/** Color temperature (in kelvin) between entries in `kelvin_table` */
+#define KELVIN_TABLE_STEP 100
+/** Number of entries in `kelvin_table` */
+#define KELVIN_TABLE_ENTRIES ((KELVIN_TABLE_MAX - KELVIN_TABLE_MIN) / KELVIN_TABLE_STEP + 1)
 
-    inline void clamp(const float min, const float max)
-    {
-        r = _clamp(r, min, max);
-        g = _clamp(g, min, max);
-        b = _clamp(b, min, max);
-        w = _clamp(w, min, max);
-    }
-};
+static_assert(sizeof(kelvin_table) / sizeof(kelvin_table[0]) == KELVIN_TABLE_ENTRIES, "kelvin_table does not match KELVIN_TABLE_*");
 
 /**
  * Implements algorithm from https://tannerhelland.com/2012/09/18/convert-temperature-rgb-algorithm-code.html
+ *
+ * Linearly interpolates between entries of `kelvin_table`, the error compared to evaluating the algorithm with
+ * powf()/logf() is less than 0.87/255 for temperatures in the range [500, 6600], and less than 0.09/255 for [6700, 10000].
+ * (The algorithm itself jumps by a few steps between 6600 and 6700, so the error peaks at 3.3/255 there)
+ *
+ * @param temp Color temperature (in kelvin), clamped to the range [500, 10000]
  */
-static vec3_t get_rgb_from_temp_unclamped(float temp)
+static rgb_q8_t get_rgb_from_temp(uint32_t temp)
 {
-    vec3_t out;
-    temp /= 100.f;
-
-    if (temp <= 66.f)
-        out.r = 255.f;
-    else
-        out.r = 329.698727446f * powf((temp - 60.f), -0.1332047592f);
-
-    if (temp <= 66.f)
-        out.g = 99.4708025861f * logf(temp) - 161.1195681661f;
-    else
-        out.g = 288.1221695283f * powf((temp - 60.f), -0.0755148492f);
-
-    if (temp >= 66.f)
-        out.b = 255.f;
-    else if (temp <= 19.f)
-        out.b = 0.f;
-    else
-        out.b = 138.5177312231f * logf(temp - 10.f) - 305.0447927307f;
-
-    out.r /= 255.0f;
-    out.g /= 255.0f;
-    out.b /= 255.0f;
+    temp = _clamp(temp, uint32_t(KELVIN_TABLE_MIN), uint32_t(KELVIN_TABLE_MAX));
+
+    const uint32_t t = temp - KELVIN_TABLE_MIN;
+    uint32_t i = t / KELVIN_TABLE_STEP;
+    uint32_t f = t % KELVIN_TABLE_STEP;
 
+    if (i == KELVIN_TABLE_ENTRIES - 1)
+        i--, f = KELVIN_TABLE_STEP;
+
+    rgb_q8_t out;
+    out.r = (kelvin_table[i][0] * (KELVIN_TABLE_STEP - f) + kelvin_table[i + 1][0] * f) / KELVIN_TABLE_STEP;
+    out.g = (kelvin_table[i][1] * (KELVIN_TABLE_STEP - f) + kelvin_table[i + 1][1] * f) / KELVIN_TABLE_STEP;
+    out.b = (kelvin_table[i][2] * (KELVIN_TABLE_STEP - f) + kelvin_table[i + 1][2] * f) / KELVIN_TABLE_STEP;
     return out;
 }
 
-/** @copydoc get_rgb_from_temp_unclamped */
-static vec3_t get_rgb_from_temp(float temp)
+/** Q15 weights of each color channel for the white component, set by sunrise_init() */
+static rgb_q8_t white_weights;
+
+void sunrise_init(uint32_t white_color_temp)
 {
-    vec3_t out = get_rgb_from_temp_unclamped(temp);
-    out.clamp(0.f, 1.f);
-    return out;
+    /* Dividing by 3 here (and by Q8_FULL to normalize the whitepoint) keeps compute_rgbw() division free */
+    const rgb_q8_t white_component_rgb = get_rgb_from_temp(white_color_temp);
+    white_weights.r = (white_component_rgb.r << 15) / (3 * Q8_FULL);
+    white_weights.g = (white_component_rgb.g << 15) / (3 * Q8_FULL);
+    white_weights.b = (white_component_rgb.b << 15) / (3 * Q8_FULL);
 }
 
 /**
- * Compute the RGBW led pixel color from a RGB color
+ * Compute the RGBW color for a RGB color
  *
- * @param rgb RGB color to convert
- * @param whitepoint RGB color of the pixel's white component
+ * @param rgb RGB color to convert, components must already be in the range [0, @ref Q8_FULL]
  */
-static led_color_t compute_led_color(vec3_t rgb, const vec3_t& whitepoint)
+static rgbw_q8_t compute_rgbw(const rgb_q8_t& rgb)
 {
-    rgb.clamp(0.f, 1.f);
+    rgbw_q8_t out;
+    out.r = rgb.r;
+    out.g = rgb.g;
+    out.b = rgb.b;
 
     /* Calculate how much each color should affect the white pixel based on
      * how much of the channel is used by the led's color temperature.
      *
      * I don't know how "correct" it is, but it does seem to work reasonably well
+     *
+     * This is linear, so computing it at the gradient stops gives the same result as computing it for every pixel
      */
-    float w;
-    w = (rgb.r * whitepoint.r + rgb.g * whitepoint.g + rgb.b * whitepoint.b) / 3.f;
-    rgb.clamp(0.f, 1.f);
-    w = _clamp(w, 0.f, 1.f);
+    out.w = (rgb.r * white_weights.r + rgb.g * white_weights.g + rgb.b * white_weights.b) >> 15;
+
+    return out;
+}
 
-    return led_color_t(rgb.r * 255.f, rgb.g * 255.f, rgb.b * 255.f, w * 255.f);
+/**
+ * Get the RGB color of a gradient stop by interpolating between keyframes
+ *
+ * @param factor Q16 sunrise factor in the range [0, @ref Q16_ONE]
+ * @param stop Index of the gradient stop (0: bottom of the strip, 1: top of the strip)
+ */
+static rgb_q8_t get_keyframe_rgb(const uint32_t factor, const int stop)
+{
+    const uint32_t frac_bits = 16 - 8;
+    static_assert((1 << 8) == SUNRISE_KEYFRAME_COUNT, "get_keyframe_rgb() assumes SUNRISE_KEYFRAME_COUNT is 256");
+
+    uint32_t i = factor >> frac_bits;
+    uint32_t f = factor & ((1 << frac_bits) - 1);
+
+    if (i == SUNRISE_KEYFRAME_COUNT)
+        i--, f = 1 << frac_bits;
+
+    const uint16_t* a = sunrise_keyframes[i][stop];
+    const uint16_t* b = sunrise_keyframes[i + 1][stop];
+
+    rgb_q8_t out;
+    out.r = (a[0] * ((1 << frac_bits) - f) + b[0] * f) >> frac_bits;
+    out.g = (a[1] * ((1 << frac_bits) - f) + b[1] * f) >> frac_bits;
+    out.b = (a[2] * ((1 << frac_bits) - f) + b[2] * f) >> frac_bits;
+    return out;
 }
 
-void sunrise_apply(const float sunrise_factor, uint32_t white_color_temp, led_color_t* out, size_t num_pixels)
+/**
+ * Render a frame without going through the cache
+ */
+static void sunrise_render(const int32_t sunrise_factor, led_pixel_t* out, size_t num_pixels)
 {
     if (sunrise_factor < 0)
     {
         memset((void*)out, 0, sizeof(*out) * num_pixels);
         return;
     }
-    const vec3_t whitepoint = get_rgb_from_temp_unclamped(white_color_temp);
+    const uint32_t factor = _min(uint32_t(sunrise_factor), Q16_ONE);
 
-    /* Color temperature for the bottom of the strip
-     * The pow() part gives a slower initial rise */
-    float target_color_temp_bot = 500.f + pow(sunrise_factor, 2.2f) * 3500.f;
+    /* The color physics (see generated/sunrise_keyframes.h) are evaluated ahead of time,
+     * so all that's left is to interpolate between the neighbouring keyframes */
+    const rgb_q8_t bot = get_keyframe_rgb(factor, 0);
+    const rgb_q8_t top = get_keyframe_rgb(factor, 1);
 
-    /* Color temperature for the top of the strip
-     * The sin^2() part causes the difference between top and bottom to
-     * increase as sunrise_factor approaches 0.5 and decrease thereafter
-     */
-    float target_color_temp_top = target_color_temp_bot + sin(sunrise_factor * PI) * sin(sunrise_factor * PI) * 300.f;
+    gradient_stop_t stops[2];
+    stops[0].pos = 0;
+    stops[0].color = compute_rgbw(bot);
+    stops[1].pos = GRADIENT_POS_ONE;
+    stops[1].color = compute_rgbw(top);
 
-    vec3_t bot = get_rgb_from_temp(target_color_temp_bot);
-    vec3_t top = get_rgb_from_temp(target_color_temp_top);
+    gradient_fill(stops, 2, out, num_pixels);
+}
 
-    float brightness = sunrise_factor * 2.f;
-    brightness = _clamp(brightness, 0.f, 1.f);
-    bot *= brightness;
-    top *= brightness;
+/** Last rendered frame */
+static led_pixel_t* cache_frame = NULL;
+/** Length of `cache_frame` */
+static size_t cache_frame_len = 0;
+/** Key of `cache_frame`, only valid if `cache_frame_len` is not 0 */
+static int32_t cache_key = 0;
+
+static sunrise_stats_t stats = {};
+
+void sunrise_apply(const int32_t sunrise_factor, led_pixel_t* out, size_t num_pixels)
+{
+    const int32_t key = sunrise_factor < 0 ? -1 : (_min(uint32_t(sunrise_factor), Q16_ONE) >> SUNRISE_CACHE_SHIFT);
 
-    for (size_t i = 0; i < num_pixels; i++)
+    if (cache_frame_len == num_pixels && cache_key == key)
     {
-        float f = float(i) / float(num_pixels - 1);
-        out[i] = compute_led_color(_mix(bot, top, f), whitepoint);
+        stats.cache_hits++;
+        memcpy((void*)out, cache_frame, sizeof(*out) * num_pixels);
+        return;
+    }
+    stats.cache_misses++;
+
+    /* Render the quantized factor, so that the output only depends on the key */
+    sunrise_render(key < 0 ? -1 : (key << SUNRISE_CACHE_SHIFT), out, num_pixels);
+
+    if (cache_frame_len != num_pixels)
+    {
+        free(cache_frame);
+        cache_frame = (led_pixel_t*)malloc(sizeof(*cache_frame) * num_pixels);
+        cache_frame_len = cache_frame ? num_pixels : 0;
     }
+    if (cache_frame)
+        memcpy(cache_frame, (void*)out, sizeof(*out) * num_pixels);
+    cache_key = key;
 }
+
+sunrise_stats_t sunrise_get_stats() { return stats; }
@@ -34,11 +34,36 @@
 #include "led.h"
 
 /**
- * Fill led color array with simulated sunrise
+ * Init sunrise simulation
  *
- * @param sunrise_factor Value between [0.f, 1.f] that represents how far the sun has risen
  * @param white_color_temp Tungsten color temperature (in kelvin) for the white color component
+ */
+void sunrise_init(uint32_t white_color_temp);
+
+/** Value of sunrise_factor when the sun has fully risen */
+#define SUNRISE_FACTOR_ONE (1 << 16)
+
+/**
+ * Fill led color array with simulated sunrise
+ *
+ * sunrise_factor is quantized to the resolution that 8-bit output can show,
+ * and the last frame is cached so that it is only rendered again when the quantized value changes.
+ *
+ * @param sunrise_factor Q16 value between [0, @ref SUNRISE_FACTOR_ONE] that represents how far the sun has risen, negative values turn off all pixels
  * @param out Array to fill
  * @param num_pixels Length of array to fill
  */
-void sunrise_apply(const float sunrise_factor, uint32_t white_color_temp, led_color_t* out, size_t num_pixels);
+void sunrise_apply(const int32_t sunrise_factor, led_pixel_t* out, size_t num_pixels);
+
+struct sunrise_stats_t
+{
+    /** Number of frames copied from the render cache */
+    uint32_t cache_hits;
+    /** Number of frames that had to be rendered */
+    uint32_t cache_misses;
+};
+
+/**
+ * Get render cache counters
+ */
+sunrise_stats_t sunrise_get_stats();
@@ -0,0 +1,167 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Exhaustive check of the civil calendar functions against the C library, and a benchmark against the old mktime()/gmtime_r() path
+ */
+#include "datetime.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+microseconds_t get_unix_time() { return 0; }
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+/**
+ * Every day from -9999-01-01 to 9999-12-31 against gmtime_r() and timegm()
+ */
+static void check_every_day()
+{
+    const int32_t first = days_from_civil(-9999, 1, 1);
+    const int32_t last = days_from_civil(9999, 12, 31);
+    for (int32_t days = first; days <= last; days++)
+    {
+        const time_t t = time_t(days) * 86400;
+        struct tm ref = {};
+        gmtime_r(&t, &ref);
+
+        const civil_date_t date = civil_from_days(days);
+        CHECK(date.year == ref.tm_year + 1900 && int(date.month) == ref.tm_mon + 1 && int(date.day) == ref.tm_mday, "civil_from_days(%ld): %ld-%lu-%lu\n",
+            long(days), long(date.year), (unsigned long)date.month, (unsigned long)date.day);
+        CHECK(days_from_civil(date.year, date.month, date.day) == days, "days_from_civil round trip of %ld\n", long(days));
+        CHECK(weekday_from_days(days) == uint32_t(ref.tm_wday), "weekday_from_days(%ld)\n", long(days));
+
+        struct tm back = {};
+        back.tm_year = ref.tm_year;
+        back.tm_mon = ref.tm_mon;
+        back.tm_mday = ref.tm_mday;
+        CHECK(timegm(&back) == t, "timegm disagrees on day %ld\n", long(days));
+    }
+    printf("Every day from -9999 to 9999: %ld days checked\n", long(last - first + 1));
+}
+
+/**
+ * Random timestamps (including before 1970) and out of range months/days against gmtime_r() and timegm()
+ */
+static void check_datetime()
+{
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<int64_t> dist(-62135596800ll * 1000000, 253402300799ll * 1000000);
+    const int count = 1000000;
+    for (int i = 0; i < count; i++)
+    {
+        const microseconds_t us = dist(rng);
+        const datetime_t dt(us);
+
+        /* Floor, the C library splits off seconds the same way */
+        const time_t t = us / 1000000 - (us % 1000000 < 0);
+        struct tm ref = {};
+        gmtime_r(&t, &ref);
+        CHECK(dt.year() == ref.tm_year + 1900 && int(dt.month()) == ref.tm_mon + 1 && int(dt.day()) == ref.tm_mday && int(dt.hour()) == ref.tm_hour
+                && int(dt.minute()) == ref.tm_min && int(dt.second()) == ref.tm_sec && microseconds_t(dt.microsecond()) == us - microseconds_t(t) * 1000000,
+            "datetime_t(%lld) fields\n", (long long)us);
+
+        const int month = int(rng() % 40) - 14;
+        const int day = int(rng() % 80) - 20;
+        struct tm norm = {};
+        norm.tm_year = ref.tm_year;
+        norm.tm_mon = month - 1;
+        norm.tm_mday = day;
+        norm.tm_hour = ref.tm_hour;
+        const microseconds_t expected = microseconds_t(timegm(&norm)) * 1000000;
+        CHECK(datetime_t(ref.tm_year + 1900, month, day, ref.tm_hour).to_microseconds_since_1970() == expected, "datetime_t(%d, %d, %d) normalization\n",
+            ref.tm_year + 1900, month, day);
+    }
+    printf("Random datetime_t values: %d checked\n", count);
+}
+
+template <typename F> static void bench(const char* name, const std::vector<microseconds_t>& input, F f)
+{
+    volatile int64_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const microseconds_t us : input)
+        sink = sink + f(us);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-44s %6.1f ns/call\n", name, elapsed * 1e9 / input.size());
+}
+
+/**
+ * The previous implementation went through struct tm: gmtime_r() to split, mktime() (with TZ=UTC) to join
+ */
+static void benchmark()
+{
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    std::mt19937_64 rng(2);
+    std::uniform_int_distribution<int64_t> dist(0, 4102444800ll * 1000000);
+    std::vector<microseconds_t> input(1000000);
+    for (microseconds_t& us : input)
+        us = dist(rng);
+
+    bench("Split (gmtime_r)", input, [](microseconds_t us) {
+        const time_t t = us / 1000000;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        return tm.tm_mday;
+    });
+    bench("Split (datetime_t fields)", input, [](microseconds_t us) { return datetime_t(us).day(); });
+
+    bench("Join (mktime)", input, [](microseconds_t us) {
+        struct tm tm = {};
+        tm.tm_year = 100 + int(us % 100);
+        tm.tm_mon = int(us % 12);
+        tm.tm_mday = 1 + int(us % 28);
+        return int64_t(mktime(&tm));
+    });
+    bench("Join (datetime_t)", input, [](microseconds_t us) {
+        return datetime_t(2000 + int(us % 100), 1 + int(us % 12), 1 + int(us % 28)).to_microseconds_since_1970();
+    });
+}
+
+int main()
+{
+    check_every_day();
+    check_datetime();
+    benchmark();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief NMEA parser checks and throughput/allocation benchmark
+ *
+ * gps.cpp is included directly, so that the parser can be fed without the UART receive path
+ */
+#include "gps.cpp"
+
+#include <chrono>
+#include <string>
+#include <stdlib.h>
+
+#if defined(__GLIBC__)
+/* Count every heap allocation made while parsing */
+static size_t allocations = 0;
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* malloc(size_t size)
+{
+    allocations++;
+    return __libc_malloc(size);
+}
+#endif
+
+static uint32_t syncs = 0;
+
+microseconds_t get_unix_time() { return 0; }
+microseconds_t sync_unix_time(const microseconds_t, const uint64_t)
+{
+    syncs++;
+    return 0;
+}
+bool core_message_post(const core_message_type_t, const void*, const size_t) { return true; }
+void gps_rx_init() { }
+size_t gps_rx_read(uint8_t*, const size_t, uint64_t*) { return 0; }
+uint32_t gps_rx_bytes_to_us(const uint32_t) { return 0; }
+bool gps_rx_available() { return false; }
+void gps_rx_wait(const uint32_t) { }
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond))                                                                                                                                           \
+        {                                                                                                                                                      \
+            failures++;                                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+        }                                                                                                                                                      \
+    } while (0)
+
+/**
+ * Append a sentence with its checksum to `out`
+ */
+static void add_sentence(std::string& out, const char* body)
+{
+    uint8_t checksum = 0;
+    for (const char* p = body; *p; p++)
+        checksum ^= *p;
+
+    char buf[NMEA_BUFFER_SIZE];
+    snprintf(buf, sizeof(buf), "$%s*%02X\r\n", body, checksum);
+    out += buf;
+}
+
+static void feed(const std::string& data)
+{
+    for (const char c : data)
+        gps_handle_character(c);
+}
+
+/** One second of output with the sentences enabled by gps_set_config(), at 2 Hz with GSV included */
+static std::string make_corpus()
+{
+    std::string r;
+    for (const char* fraction : { "000", "500" })
+    {
+        char buf[NMEA_BUFFER_SIZE];
+        snprintf(buf, sizeof(buf), "GPRMC,064951.%s,A,2307.1256,N,12016.4438,E,0.03,165.48,260406,3.05,W,A", fraction);
+        add_sentence(r, buf);
+        snprintf(buf, sizeof(buf), "GPGGA,064951.%s,2307.1256,N,12016.4438,E,1,8,0.95,39.9,M,17.8,M,,", fraction);
+        add_sentence(r, buf);
+        add_sentence(r, "GPGSA,A,3,29,21,26,15,18,09,06,10,,,,,2.32,0.95,2.11");
+        snprintf(buf, sizeof(buf), "GPZDA,064951.%s,26,04,2006,,", fraction);
+        add_sentence(r, buf);
+    }
+    add_sentence(r, "GPGSV,3,1,09,29,36,029,42,21,46,314,43,26,44,020,43,15,21,321,39");
+    add_sentence(r, "GPGSV,3,2,09,18,26,314,40,09,57,170,44,06,20,229,37,10,26,084,37");
+    add_sentence(r, "GPGSV,3,3,09,07,,,26");
+    return r;
+}
+
+static void check_corpus(const std::string& corpus)
+{
+    feed(corpus);
+
+    const gps_fix_t& fix = gps_data.fix;
+    CHECK(gps_data.stats.parser.sentences == 11, "sentences: %lu\n", (unsigned long)gps_data.stats.parser.sentences);
+    CHECK(gps_data.stats.parser.checksum_errors == 0 && gps_data.stats.parser.unhandled == 0, "checksum errors/unhandled sentences\n");
+    CHECK(fix.latitude == 231187600 && fix.longitude == 1202740633, "position: %ld, %ld\n", long(fix.latitude), long(fix.longitude));
+    CHECK(fix.fix_status == 1 && fix.fix_mode == 3 && fix.satellites_used == 8 && fix.satellites_in_view == 9, "fix: %d %ld %ld %ld\n", int(fix.fix_status),
+        long(fix.fix_mode), long(fix.satellites_used), long(fix.satellites_in_view));
+    CHECK(fix.altitude == 399 && fix.pdop == 232 && fix.hdop == 95 && fix.vdop == 211, "altitude/DOP: %ld %ld %ld %ld\n", long(fix.altitude), long(fix.pdop),
+        long(fix.hdop), long(fix.vdop));
+    CHECK(fix.rmc_valid && fix.speed == 3 && fix.course == 16548, "RMC: %d %ld %ld\n", fix.rmc_valid, long(fix.speed), long(fix.course));
+    /* Bytes fed straight to the parser have no arrival times, so ZDA can't be timed by the start of its burst */
+    CHECK(syncs == 0 && gps_data.stats.sync.skipped == 2, "syncs: %lu, skipped: %lu\n", (unsigned long)syncs, (unsigned long)gps_data.stats.sync.skipped);
+
+    /* A corrupted checksum must be rejected without touching the fix */
+    std::string corrupted;
+    add_sentence(corrupted, "GPGGA,064951.000,1111.0000,N,12016.4438,E,1,8,0.95,39.9,M,17.8,M,,");
+    corrupted[20] = '2';
+    feed(corrupted);
+    CHECK(gps_data.stats.parser.checksum_errors == 1 && fix.latitude == 231187600, "corrupted sentence accepted\n");
+
+    /* A valid checksum must be followed by the end of the line */
+    std::string unterminated;
+    add_sentence(unterminated, "GPGGA,064951.000,1111.0000,N,12016.4438,E,1,8,0.95,39.9,M,17.8,M,,");
+    std::string run_on = unterminated;
+    unterminated.replace(unterminated.size() - 2, 1, "X");
+    run_on.erase(run_on.size() - 2);
+    run_on += unterminated;
+    feed(unterminated);
+    feed(run_on);
+    CHECK(gps_data.stats.parser.framing_errors == 3 && fix.latitude == 231187600, "framing errors: %lu\n", (unsigned long)gps_data.stats.parser.framing_errors);
+
+    /* Malformed fields must leave the previous values in place */
+    std::string malformed;
+    add_sentence(malformed, "GPGGA,064952.000,2307.1256,X,12016.4438,E,1,8,0.95,.,M,17.8,M,,");
+    add_sentence(malformed, "GPGGA,064952.000,18107.1256,N,99999999999999999999.9,E,1,8,0.95,39.9,M,17.8,M,,");
+    add_sentence(malformed, "GPGGA,064952.000,2307.1256,N,12016.4438,E,1,8,0.95,-.,M,17.8,M,,");
+    feed(malformed);
+    CHECK(fix.latitude == 231187600 && fix.longitude == 1202740633, "malformed position accepted: %ld, %ld\n", long(fix.latitude), long(fix.longitude));
+    CHECK(fix.altitude == 399, "malformed altitude accepted: %ld\n", long(fix.altitude));
+}
+
+static void benchmark(const std::string& corpus)
+{
+    const int iterations = 20000;
+    const uint32_t sentences_start = gps_data.stats.parser.sentences;
+#if defined(__GLIBC__)
+    const size_t allocations_start = allocations;
+#endif
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        feed(corpus);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#if defined(__GLIBC__)
+    const size_t parse_allocations = allocations - allocations_start;
+#endif
+
+    const uint32_t sentences = gps_data.stats.parser.sentences - sentences_start;
+    printf("Parse throughput:  %.1f MB/s (%.0f sentences/s)\n", corpus.size() * iterations / elapsed / 1e6, sentences / elapsed);
+#if defined(__GLIBC__)
+    printf("Allocations:       %.3f per sentence\n", double(parse_allocations) / sentences);
+    CHECK(parse_allocations == 0, "parser allocated memory\n");
+#endif
+}
+
+int main()
+{
+    const std::string corpus = make_corpus();
+    check_corpus(corpus);
+    benchmark(corpus);
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Simulation of the GPS module output to check how clock syncs are timed
+ *
+ * gps.cpp is included directly, and the UART receive path is replaced by a queue of bytes with simulated arrival times
+ */
+#include "gps.cpp"
+
+#include "host_pps.h"
+
+#include <algorithm>
+#include <string>
+#include <stdlib.h>
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+bool core_message_post(const core_message_type_t, const void*, const size_t) { return true; }
+
+/** Bytes that have arrived but not been read yet */
+static std::string rx_pending;
+/** `time_us_64()` value at which the last byte of `rx_pending` finished arriving */
+static uint64_t rx_pending_end = 0;
+
+void gps_rx_init() { }
+uint32_t gps_rx_bytes_to_us(const uint32_t bytes) { return uint64_t(bytes) * 10 * 1000000 / GPS_BAUD_RATE; }
+bool gps_rx_available() { return !rx_pending.empty(); }
+void gps_rx_wait(const uint32_t) { }
+size_t gps_rx_read(uint8_t* buf, const size_t max_len, uint64_t* last_byte_time)
+{
+    const size_t len = rx_pending.size() < max_len ? rx_pending.size() : max_len;
+    memcpy(buf, rx_pending.data(), len);
+    rx_pending.erase(0, len);
+    if (last_byte_time)
+        *last_byte_time = rx_pending_end - gps_rx_bytes_to_us(rx_pending.size());
+    return len;
+}
+
+/**
+ * Append a sentence with its checksum to `out`
+ */
+static void add_sentence(std::string& out, const char* body)
+{
+    uint8_t checksum = 0;
+    for (const char* p = body; *p; p++)
+        checksum ^= *p;
+
+    char buf[NMEA_BUFFER_SIZE];
+    snprintf(buf, sizeof(buf), "$%s*%02X\r\n", body, checksum);
+    out += buf;
+}
+
+/**
+ * Receive bytes back to back starting at `start`, then run the GPS loop
+ *
+ * @param split Number of bytes to hand to the GPS loop before the rest, to simulate it catching up mid-burst (0 to receive everything at once)
+ */
+static void receive(const std::string& data, const uint64_t start, const size_t split = 0)
+{
+    size_t done = 0;
+    for (const size_t end : { split, data.size() })
+    {
+        if (end <= done)
+            continue;
+        rx_pending += data.substr(done, end - done);
+        rx_pending_end = start + gps_rx_bytes_to_us(end);
+        host_set_time_us(rx_pending_end + 100);
+        gps_loop();
+        done = end;
+    }
+}
+
+/** Interval between fixes, matches the PMTK220 rate set by gps_set_config() */
+#define FIX_INTERVAL_US (500 * 1000)
+/** Local time of fix 0, the local clock runs at exactly the GPS rate */
+#define FIX_0_LOCAL (10 * MICROSECONDS_PER_SECOND)
+
+/** Unix time of fix 0 */
+static microseconds_t fix_0_unix = 0;
+
+static uint64_t fix_local(const int fix) { return FIX_0_LOCAL + uint64_t(fix) * FIX_INTERVAL_US; }
+static microseconds_t fix_unix(const int fix) { return fix_0_unix + microseconds_t(fix) * FIX_INTERVAL_US; }
+
+/**
+ * Output burst of a fix, as sent by a module configured by gps_set_config()
+ *
+ * @param satellites Number of satellites used, which changes the length of GSA and so where ZDA falls in the burst
+ */
+static std::string make_burst(const int fix, const int satellites)
+{
+    const datetime_t t(fix_unix(fix));
+
+    char hms[16];
+    snprintf(hms, sizeof(hms), "%02d%02d%02d.%03d", int(t.hour()), int(t.minute()), int(t.second()), int(t.microsecond() / 1000));
+
+    std::string prns;
+    for (int i = 0; i < 12; i++)
+        prns += i < satellites ? std::to_string(10 + i) + "," : std::string(",");
+
+    std::string r;
+    char buf[NMEA_BUFFER_SIZE];
+    snprintf(buf, sizeof(buf), "GPRMC,%s,A,2307.1256,N,12016.4438,E,0.03,165.48,%02d%02d%02d,,,A", hms, int(t.day()), int(t.month()),
+        int(t.year() % 100));
+    add_sentence(r, buf);
+    snprintf(buf, sizeof(buf), "GPGGA,%s,2307.1256,N,12016.4438,E,1,%02d,0.95,39.9,M,17.8,M,,", hms, satellites);
+    add_sentence(r, buf);
+    snprintf(buf, sizeof(buf), "GPGSA,A,3,%s2.32,0.95,2.11", prns.c_str());
+    add_sentence(r, buf);
+    snprintf(buf, sizeof(buf), "GPZDA,%s,%02d,%02d,%04d,,", hms, int(t.day()), int(t.month()), int(t.year()));
+    add_sentence(r, buf);
+    return r;
+}
+
+/**
+ * Receive the burst of a fix
+ *
+ * @param delay Time from the fix to the start of the burst
+ */
+static void receive_fix(const int fix, const uint64_t delay = GPS_NMEA_LATENCY_US, const int satellites = 8, const size_t split = 0)
+{
+    receive(make_burst(fix, satellites), fix_local(fix) + delay, split);
+}
+
+/**
+ * Error of the clock against the simulated GPS time at the present
+ */
+static microseconds_t clock_error() { return get_unix_time() - (fix_0_unix + microseconds_t(time_us_64() - FIX_0_LOCAL)); }
+
+/**
+ * Without PPS, ZDA is timed by the start of its burst, wherever it falls in the burst
+ */
+static void check_burst_timing()
+{
+    const gps_sync_stats_t& sync = gps_data.stats.sync;
+
+    /* The first sync steps the clock, after that the error must stay at the rounding of the byte times
+     * while the number of satellites moves ZDA around by up to 24 bytes (25 ms) */
+    microseconds_t max_residual = 0;
+    for (int fix = 0; fix < 20; fix++)
+    {
+        receive_fix(fix, GPS_NMEA_LATENCY_US, 4 + fix % 9, fix % 3 == 1 ? 100 : 0);
+        if (fix)
+            max_residual = std::max(max_residual, std::abs(sync.residual));
+    }
+    CHECK(sync.count == 20 && sync.pps_count == 0 && sync.skipped == 0, "Burst timed syncs: %lu (%lu PPS, %lu skipped)\n", (unsigned long)sync.count,
+        (unsigned long)sync.pps_count, (unsigned long)sync.skipped);
+    CHECK(max_residual <= 2 && std::abs(clock_error()) <= 2, "Burst timing: residual %lld us, clock error %lld us\n", (long long)max_residual,
+        (long long)clock_error());
+
+    /* An acknowledgement just before the burst hides where the burst started */
+    std::string ack;
+    add_sentence(ack, "PMTK001,314,3");
+    receive(ack, fix_local(20) - 20 * 1000);
+    receive_fix(20);
+    CHECK(sync.count == 20 && sync.skipped == 1, "Burst after an acknowledgement was used\n");
+
+    /* The next burst is usable again */
+    receive_fix(21);
+    CHECK(sync.count == 21 && std::abs(sync.residual) <= 2, "Burst after a skipped one: %lu syncs, residual %lld us\n", (unsigned long)sync.count,
+        (long long)sync.residual);
+}
+
+/** Burst delay used while checking PPS timing, far enough from @ref GPS_NMEA_LATENCY_US that an arrival timed sync stands out */
+#define PPS_TEST_BURST_DELAY (30 * 1000)
+
+/**
+ * Pulses present, missing, late, and timed out
+ *
+ * The bursts start @ref PPS_TEST_BURST_DELAY after each fix, so only pulse timed syncs keep the clock exact
+ */
+static void check_pps_timing()
+{
+    const gps_sync_stats_t& sync = gps_data.stats.sync;
+
+    /* Pulses on every whole second: RMC syncs to the pulse, ZDA must not use the same pulse again, and the .500 sentences are skipped */
+    int fix = 22;
+    gps_sync_stats_t before = sync;
+    for (; fix < 42; fix++)
+    {
+        if (fix % 2 == 0)
+            host_pps_add_pulse(fix_local(fix));
+        receive_fix(fix, PPS_TEST_BURST_DELAY);
+        CHECK(std::abs(sync.residual) <= 2 && std::abs(clock_error()) <= 2, "Fix %d: residual %lld us, clock error %lld us\n", fix,
+            (long long)sync.residual, (long long)clock_error());
+    }
+    CHECK(sync.pps_count - before.pps_count == 10 && sync.count - before.count == 10 && sync.skipped - before.skipped == 20,
+        "With pulses: %lu syncs (%lu PPS, %lu skipped)\n", (unsigned long)(sync.count - before.count), (unsigned long)(sync.pps_count - before.pps_count),
+        (unsigned long)(sync.skipped - before.skipped));
+
+    /* A missing pulse leaves the previous one more than a second before the sentences, so neither RMC nor ZDA is used */
+    before = sync;
+    receive_fix(fix++, PPS_TEST_BURST_DELAY);
+    receive_fix(fix++, PPS_TEST_BURST_DELAY);
+    CHECK(sync.count == before.count && sync.skipped - before.skipped == 4, "Missing pulse: %lu syncs, %lu skipped\n",
+        (unsigned long)(sync.count - before.count), (unsigned long)(sync.skipped - before.skipped));
+
+    /* A pulse that arrives after the sentences started can't be the one they describe */
+    before = sync;
+    host_pps_add_pulse(fix_local(fix) + PPS_TEST_BURST_DELAY + 100 * 1000);
+    receive_fix(fix++, PPS_TEST_BURST_DELAY);
+    CHECK(sync.count == before.count && sync.skipped - before.skipped == 2, "Late pulse: %lu syncs, %lu skipped\n",
+        (unsigned long)(sync.count - before.count), (unsigned long)(sync.skipped - before.skipped));
+
+    /* Back to normal */
+    uint64_t last_pulse = 0;
+    for (const int end = fix + 4; fix < end; fix++)
+    {
+        if (fix % 2 == 0)
+            host_pps_add_pulse(last_pulse = fix_local(fix));
+        receive_fix(fix, PPS_TEST_BURST_DELAY);
+    }
+    CHECK(std::abs(clock_error()) <= 2, "After recovering: clock error %lld us\n", (long long)clock_error());
+
+    /* Pulses stop, once GPS_PPS_TIMEOUT_US has passed ZDA is timed by its burst again, which is PPS_TEST_BURST_DELAY late */
+    before = sync;
+    bool timed_out = false;
+    for (const int end = fix + 8; fix < end; fix++)
+    {
+        const gps_sync_stats_t prev = sync;
+        receive_fix(fix, PPS_TEST_BURST_DELAY);
+        const bool expect_sync = time_us_64() - last_pulse >= GPS_PPS_TIMEOUT_US;
+        CHECK((sync.count - prev.count == 1) == expect_sync, "Fix %d, %llu us after the last pulse: %lu syncs\n", fix,
+            (unsigned long long)(time_us_64() - last_pulse), (unsigned long)(sync.count - prev.count));
+        if (expect_sync && !timed_out)
+        {
+            timed_out = true;
+            CHECK(std::abs(sync.residual - PPS_TEST_BURST_DELAY) <= 2, "First arrival timed sync: residual %lld us\n", (long long)sync.residual);
+        }
+    }
+    CHECK(timed_out && sync.pps_count == before.pps_count, "No arrival timed sync after the pulses stopped\n");
+}
+
+int main()
+{
+    fix_0_unix = datetime_t(2025, 6, 1).to_microseconds_since_1970() + 12 * MICROSECONDS_PER_HOUR;
+    init_unix_time();
+    host_set_time_us(1);
+
+    check_burst_timing();
+    check_pps_timing();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Check of the stepped gradient kernel against a double precision reference
+ */
+#include "gradient.h"
+
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+/** Largest difference allowed between gradient_fill() and the reference, per channel in 8-bit steps */
+#define MAX_CHANNEL_ERROR 1
+
+/**
+ * Color of a gradient at a position, evaluated in double precision
+ *
+ * @param pos Gradient position, scaled like @ref gradient_stop_t::pos
+ * @param channel Output channel for each of R, G, B, and W
+ */
+static double reference_channel(const std::vector<gradient_stop_t>& stops, const double pos, const int channel)
+{
+    auto get = [channel](const gradient_stop_t& s) -> double {
+        const uint32_t c[4] = { s.color.r, s.color.g, s.color.b, s.color.w };
+        return c[channel];
+    };
+
+    if (pos < stops.front().pos)
+        return get(stops.front());
+    for (size_t s = 0; s + 1 < stops.size(); s++)
+    {
+        if (pos >= stops[s].pos && pos < stops[s + 1].pos)
+        {
+            const double t = (pos - stops[s].pos) / (double(stops[s + 1].pos) - stops[s].pos);
+            return get(stops[s]) + (get(stops[s + 1]) - get(stops[s])) * t;
+        }
+    }
+    return get(stops.back());
+}
+
+/**
+ * Random gradients with 1 to 6 stops (including coincident stops) on 1 to 1000 pixel strips
+ */
+static void check_random_gradients()
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint32_t> channel(0, 255 << 8);
+    std::uniform_int_distribution<uint32_t> position(0, GRADIENT_POS_ONE);
+    std::uniform_int_distribution<int> stop_count(1, 6);
+    std::uniform_int_distribution<size_t> pixel_count(1, 1000);
+
+    const int shifts[4] = { LED_BYTE_POS_R * 8, LED_BYTE_POS_G * 8, LED_BYTE_POS_B * 8, LED_BYTE_POS_W * 8 };
+
+    int max_error = 0;
+    const int gradients = 20000;
+    for (int g = 0; g < gradients; g++)
+    {
+        std::vector<gradient_stop_t> stops(stop_count(rng));
+        for (gradient_stop_t& s : stops)
+        {
+            /* Some stops at the ends and on top of each other, where rounding is most likely to go wrong */
+            const uint32_t p = position(rng);
+            s.pos = p % 8 == 0 ? 0 : (p % 8 == 1 ? GRADIENT_POS_ONE : p);
+            s.color = { channel(rng), channel(rng), channel(rng), channel(rng) };
+        }
+        std::sort(stops.begin(), stops.end(), [](const gradient_stop_t& a, const gradient_stop_t& b) { return a.pos < b.pos; });
+        if (stops.size() > 2 && g % 4 == 0)
+            stops[1].pos = stops[2].pos;
+
+        const size_t num_pixels = g < 1000 ? g + 1 : pixel_count(rng);
+        std::vector<led_pixel_t> out(num_pixels);
+        gradient_fill(stops.data(), stops.size(), out.data(), num_pixels);
+
+        const double span = num_pixels > 1 ? num_pixels - 1 : 1;
+        for (size_t i = 0; i < num_pixels; i++)
+        {
+            const double pos = i * double(GRADIENT_POS_ONE) / span;
+            for (int c = 0; c < 4; c++)
+            {
+                if (!LED_IS_RGBW && c == 3)
+                    continue;
+                const int expected = int(floor(reference_channel(stops, pos, c) / 256.0));
+                const int actual = (out[i] >> shifts[c]) & 0xFF;
+                const int error = abs(actual - expected);
+                CHECK(error <= MAX_CHANNEL_ERROR, "Gradient %d, pixel %zu/%zu, channel %d: %d instead of %d\n", g, i, num_pixels, c, actual, expected);
+                max_error = std::max(max_error, error);
+            }
+        }
+    }
+    printf("Max channel error over %d random gradients: %d/255\n", gradients, max_error);
+}
+
+int main()
+{
+    check_random_gradients();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Scripted GPS 1PPS source for host builds, in place of gps_pps.cpp (Implementation)
+ */
+#include "host_pps.h"
+
+#include "hardware/timer.h"
+
+#include <algorithm>
+#include <vector>
+
+static std::vector<uint64_t> pulses;
+
+void host_pps_add_pulse(const uint64_t time)
+{
+    hard_assert(pulses.empty() || time > pulses.back());
+    pulses.push_back(time);
+}
+
+void gps_pps_init() { }
+
+/**
+ * Get the number of pulses that have happened by now
+ */
+static uint32_t pulses_seen() { return std::upper_bound(pulses.begin(), pulses.end(), time_us_64()) - pulses.begin(); }
+
+bool gps_pps_get_last(uint64_t& time)
+{
+    const uint32_t count = pulses_seen();
+    if (!count)
+        return false;
+    time = pulses[count - 1];
+    return true;
+}
+
+uint32_t gps_pps_get_count() { return pulses_seen(); }
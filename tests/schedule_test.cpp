@@ -0,0 +1,286 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Check of the daily schedule across daylight savings transitions and midnight
+ */
+#include "schedule.h"
+
+#include "sunrise.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+microseconds_t get_unix_time() { return 0; }
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+#define HOUR MICROSECONDS_PER_HOUR
+#define MINUTE MICROSECONDS_PER_MINUTE
+
+/** Events spread over the morning */
+static const schedule_config_t morning = {
+    timespan_t(0, 6, 0, 0),
+    timespan_t(0, 6, 30, 0),
+    timespan_t(0, 7, 0, 0),
+    timespan_t(0, 8, 0, 0),
+};
+
+/** Events inside of the hours skipped and repeated by US daylight savings transitions */
+static const schedule_config_t overnight = {
+    timespan_t(0, 1, 30, 0),
+    timespan_t(0, 2, 30, 0),
+    timespan_t(0, 3, 0, 0),
+    timespan_t(0, 4, 0, 0),
+};
+
+static const schedule_config_t* const configs[] = { &morning, &overnight };
+
+static const char* const zones[] = {
+    "EST5EDT,M3.2.0,M11.1.0",
+    /* Southern hemisphere, with transitions at midnight */
+    "<-04>4<-03>,M9.1.6/24,M4.1.6/24",
+    /* Half hour offset */
+    "ACST-9:30ACDT,M10.1.0,M4.1.0/3",
+};
+
+static datetime_t local_day(const timezone_t& tz, const microseconds_t utc) { return tz.to_local(datetime_t(utc)).get_midnight(); }
+
+/**
+ * Check the boundaries of every event of the day containing `utc` with a fresh schedule
+ */
+static void check_boundaries(const timezone_t& tz, const schedule_config_t& config, const microseconds_t utc)
+{
+    schedule_t s(tz, config);
+    s.update(utc);
+
+    const microseconds_t start = s.get_event_time(SCHEDULE_EVENT_START);
+    const microseconds_t full_power = s.get_event_time(SCHEDULE_EVENT_FULL_POWER);
+    const microseconds_t off_forced = s.get_event_time(SCHEDULE_EVENT_OFF_FORCED);
+
+    CHECK(s.get_sunrise_factor(start - 1) == -1, "Sunrise factor before start\n");
+    CHECK(s.get_sunrise_factor(start) == 0, "Sunrise factor at start\n");
+    CHECK(s.get_sunrise_factor(full_power - 1) >= SUNRISE_FACTOR_ONE - 1 - SUNRISE_FACTOR_ONE * MINUTE / (full_power - start)
+            && s.get_sunrise_factor(full_power - 1) < SUNRISE_FACTOR_ONE,
+        "Sunrise factor just before full power\n");
+    CHECK(s.get_sunrise_factor(full_power) == SUNRISE_FACTOR_ONE, "Sunrise factor at full power\n");
+    CHECK(s.get_sunrise_factor(off_forced - 1) == SUNRISE_FACTOR_ONE, "Sunrise factor just before off\n");
+    CHECK(s.get_sunrise_factor(off_forced) == -1, "Sunrise factor at off\n");
+
+    /* Each event only counts as passed once the time reaches it */
+    for (int type = 0; type < SCHEDULE_EVENT_COUNT; type++)
+    {
+        const microseconds_t t = s.get_event_time(schedule_event_type_t(type));
+
+        s.update(t - 1);
+        CHECK(s.get_next_event().time <= t && s.time_until_next_event(t - 1) == s.get_next_event().time - (t - 1), "%s not pending just before it\n",
+            schedule_event_name(schedule_event_type_t(type)));
+
+        s.update(t);
+        CHECK(s.get_next_event().time > t || s.get_next_event().type == SCHEDULE_EVENT_MIDNIGHT, "%s still pending at its time\n",
+            schedule_event_name(schedule_event_type_t(type)));
+    }
+}
+
+/**
+ * Walk a schedule minute by minute from `begin` to `end`, checking it against the local days of the timezone
+ */
+static void check_walk(const char* zone, const timezone_t& tz, const schedule_config_t& config, const microseconds_t begin, const microseconds_t end)
+{
+    schedule_t s(tz, config);
+
+    uint32_t days = 0;
+    datetime_t day(INT64_MIN);
+    for (microseconds_t t = begin; t < end; t += MINUTE)
+    {
+        const datetime_t midnight = local_day(tz, t);
+        const bool new_day = midnight != day;
+        day = midnight;
+        days += new_day;
+
+        CHECK(s.update(t) == new_day, "%s at %lld: Recomputed %d instead of %d\n", zone, (long long)t, !new_day, new_day);
+        CHECK(s.get_recompute_count() == days, "%s at %lld: %u recomputes for %u days\n", zone, (long long)t, s.get_recompute_count(), days);
+        if (!new_day)
+            continue;
+
+        /* The day runs from the first to the last instant with its local date */
+        const microseconds_t day_start = s.get_day_start();
+        const microseconds_t day_end = s.get_event_time(SCHEDULE_EVENT_MIDNIGHT);
+        CHECK(day_start <= t && t < day_end, "%s at %lld: Outside of the day\n", zone, (long long)t);
+        CHECK(local_day(tz, day_start) == day && local_day(tz, day_start - 1) != day, "%s at %lld: Bad day start\n", zone, (long long)t);
+        CHECK(local_day(tz, day_end - 1) == day && local_day(tz, day_end) != day, "%s at %lld: Bad day end\n", zone, (long long)t);
+
+        /* Sorted by time, midnight last, every event present once */
+        const schedule_event_t* prev = NULL;
+        uint32_t seen = 0;
+        for (int i = 0; i < SCHEDULE_EVENT_COUNT; i++)
+        {
+            s.update(prev ? prev->time : t);
+            const schedule_event_t& e = s.get_next_event();
+            CHECK(!prev || prev->time <= e.time, "%s at %lld: Events out of order\n", zone, (long long)t);
+            CHECK(e.time == s.get_event_time(e.type), "%s at %lld: Event time mismatch\n", zone, (long long)t);
+            seen |= 1u << e.type;
+            prev = &e;
+            if (e.type == SCHEDULE_EVENT_MIDNIGHT)
+                break;
+        }
+        s.update(t);
+
+        /* Events land on their local time, unless it was skipped, and repeated local times resolve to their first occurrence */
+        const timespan_t offsets[] = { config.start, config.full_power, config.off_allowed, config.off_forced };
+        for (int type = 0; type < SCHEDULE_EVENT_MIDNIGHT; type++)
+        {
+            const datetime_t wanted = day + offsets[type];
+            const microseconds_t e = s.get_event_time(schedule_event_type_t(type));
+            const timespan_t shift = tz.to_local(datetime_t(e)) - wanted;
+            CHECK(shift == timespan_t(0) || (shift == timespan_t(HOUR) && tz.to_local(datetime_t(e - HOUR)) < wanted),
+                "%s at %lld: %s shifted by %lld us\n", zone, (long long)t, schedule_event_name(schedule_event_type_t(type)),
+                (long long)shift.to_microseconds_since_1970());
+            CHECK(tz.to_local(datetime_t(e - HOUR)) != wanted, "%s at %lld: %s is not the first occurrence\n", zone, (long long)t,
+                schedule_event_name(schedule_event_type_t(type)));
+        }
+
+        check_boundaries(tz, config, t);
+    }
+
+    /* Stepping the clock back or ahead by days recomputes the events */
+    const uint32_t count = s.get_recompute_count();
+    CHECK(s.update(end - 3 * 24 * HOUR) && s.get_recompute_count() == count + 1 && local_day(tz, s.get_day_start()) == local_day(tz, end - 3 * 24 * HOUR),
+        "%s: Step back not recomputed\n", zone);
+    CHECK(s.update(end + 2 * 24 * HOUR) && s.get_recompute_count() == count + 2 && local_day(tz, s.get_day_start()) == local_day(tz, end + 2 * 24 * HOUR),
+        "%s: Step ahead not recomputed\n", zone);
+}
+
+/**
+ * Check the days around the US transitions of 2025 against hand computed times
+ */
+static void check_us_2025()
+{
+    timezone_t tz;
+    tz.parse("EST5EDT,M3.2.0,M11.1.0");
+
+    struct expected_t
+    {
+        const schedule_config_t* config;
+        datetime_t day;
+        /** UTC times of start, full_power, off_allowed, off_forced, and midnight */
+        datetime_t times[SCHEDULE_EVENT_COUNT];
+        /** Event types in the order they occur */
+        schedule_event_type_t order[SCHEDULE_EVENT_COUNT];
+    };
+
+    static const expected_t expected[] = {
+        /* Spring forward: 23 hour day */
+        { &morning, datetime_t(2025, 3, 9),
+            { datetime_t(2025, 3, 9) + timespan_t(0, 10, 0, 0), datetime_t(2025, 3, 9) + timespan_t(0, 10, 30, 0),
+                datetime_t(2025, 3, 9) + timespan_t(0, 11, 0, 0), datetime_t(2025, 3, 9) + timespan_t(0, 12, 0, 0),
+                datetime_t(2025, 3, 10) + timespan_t(0, 4, 0, 0) },
+            { SCHEDULE_EVENT_START, SCHEDULE_EVENT_FULL_POWER, SCHEDULE_EVENT_OFF_ALLOWED, SCHEDULE_EVENT_OFF_FORCED, SCHEDULE_EVENT_MIDNIGHT } },
+        /* 02:30 is skipped and pushed forward to 03:30, after 03:00 */
+        { &overnight, datetime_t(2025, 3, 9),
+            { datetime_t(2025, 3, 9) + timespan_t(0, 6, 30, 0), datetime_t(2025, 3, 9) + timespan_t(0, 7, 30, 0),
+                datetime_t(2025, 3, 9) + timespan_t(0, 7, 0, 0), datetime_t(2025, 3, 9) + timespan_t(0, 8, 0, 0),
+                datetime_t(2025, 3, 10) + timespan_t(0, 4, 0, 0) },
+            { SCHEDULE_EVENT_START, SCHEDULE_EVENT_OFF_ALLOWED, SCHEDULE_EVENT_FULL_POWER, SCHEDULE_EVENT_OFF_FORCED, SCHEDULE_EVENT_MIDNIGHT } },
+        /* Fall back: 25 hour day */
+        { &morning, datetime_t(2025, 11, 2),
+            { datetime_t(2025, 11, 2) + timespan_t(0, 11, 0, 0), datetime_t(2025, 11, 2) + timespan_t(0, 11, 30, 0),
+                datetime_t(2025, 11, 2) + timespan_t(0, 12, 0, 0), datetime_t(2025, 11, 2) + timespan_t(0, 13, 0, 0),
+                datetime_t(2025, 11, 3) + timespan_t(0, 5, 0, 0) },
+            { SCHEDULE_EVENT_START, SCHEDULE_EVENT_FULL_POWER, SCHEDULE_EVENT_OFF_ALLOWED, SCHEDULE_EVENT_OFF_FORCED, SCHEDULE_EVENT_MIDNIGHT } },
+        /* 01:30 is repeated and resolves to the daylight savings occurrence */
+        { &overnight, datetime_t(2025, 11, 2),
+            { datetime_t(2025, 11, 2) + timespan_t(0, 5, 30, 0), datetime_t(2025, 11, 2) + timespan_t(0, 7, 30, 0),
+                datetime_t(2025, 11, 2) + timespan_t(0, 8, 0, 0), datetime_t(2025, 11, 2) + timespan_t(0, 9, 0, 0),
+                datetime_t(2025, 11, 3) + timespan_t(0, 5, 0, 0) },
+            { SCHEDULE_EVENT_START, SCHEDULE_EVENT_FULL_POWER, SCHEDULE_EVENT_OFF_ALLOWED, SCHEDULE_EVENT_OFF_FORCED, SCHEDULE_EVENT_MIDNIGHT } },
+    };
+
+    for (const expected_t& e : expected)
+    {
+        schedule_t s(tz, *e.config);
+        s.update(tz.to_utc(e.day).to_microseconds_since_1970());
+
+        CHECK(s.get_day_start() == tz.to_utc(e.day).to_microseconds_since_1970(), "%04ld-%02ld-%02ld: Day start\n", (long)e.day.year(),
+            (long)e.day.month(), (long)e.day.day());
+        for (int type = 0; type < SCHEDULE_EVENT_COUNT; type++)
+            CHECK(s.get_event_time(schedule_event_type_t(type)) == e.times[type].to_microseconds_since_1970(), "%04ld-%02ld-%02ld: %s at %lld\n",
+                (long)e.day.year(), (long)e.day.month(), (long)e.day.day(), schedule_event_name(schedule_event_type_t(type)),
+                (long long)s.get_event_time(schedule_event_type_t(type)));
+
+        /* Walk through the events in order */
+        for (int i = 0; i < SCHEDULE_EVENT_COUNT; i++)
+        {
+            const schedule_event_t& next = s.get_next_event();
+            CHECK(next.type == e.order[i], "%04ld-%02ld-%02ld: Event %d is %s instead of %s\n", (long)e.day.year(), (long)e.day.month(),
+                (long)e.day.day(), i, schedule_event_name(next.type), schedule_event_name(e.order[i]));
+            if (next.type != SCHEDULE_EVENT_MIDNIGHT)
+                s.update(next.time);
+        }
+    }
+
+    /* The overnight sunrise ramps across the skipped hour in real time */
+    schedule_t s(tz, overnight);
+    const microseconds_t transition = (datetime_t(2025, 3, 9) + timespan_t(0, 7, 0, 0)).to_microseconds_since_1970();
+    s.update(transition);
+    CHECK(s.get_sunrise_factor(transition) == SUNRISE_FACTOR_ONE / 2, "Sunrise factor at the transition is %ld\n", (long)s.get_sunrise_factor(transition));
+}
+
+int main()
+{
+    for (const char* zone : zones)
+    {
+        timezone_t tz;
+        CHECK(tz.parse(zone), "%s rejected\n", zone);
+
+        /* Walk the days around every transition of 2025 */
+        const microseconds_t year_begin = datetime_t(2025, 1, 1).to_microseconds_since_1970();
+        const microseconds_t year_end = datetime_t(2026, 1, 1).to_microseconds_since_1970();
+        uint32_t transitions = 0;
+        for (microseconds_t t = year_begin; t < year_end; t += HOUR)
+        {
+            if (tz.is_dst(datetime_t(t)) == tz.is_dst(datetime_t(t + HOUR)))
+                continue;
+            for (const schedule_config_t* config : configs)
+                check_walk(zone, tz, *config, t - 3 * 24 * HOUR, t + 3 * 24 * HOUR);
+            transitions++;
+        }
+        CHECK(transitions == 2, "%s: %u transitions in 2025\n", zone, transitions);
+    }
+    check_us_2025();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
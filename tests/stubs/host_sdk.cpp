@@ -0,0 +1,62 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Minimal stand-ins for the pico-sdk functions used by the host tested sources (Implementation)
+ */
+#include "host_sdk.h"
+
+#include <atomic>
+
+static std::atomic<uint64_t> host_time { 0 };
+
+void host_set_time_us(const uint64_t t) { host_time = t; }
+uint64_t time_us_64() { return host_time; }
+uint32_t time_us_32() { return uint32_t(host_time); }
+
+void __dmb() { std::atomic_thread_fence(std::memory_order_seq_cst); }
+
+static std::atomic<uint32_t> spin_locks[32];
+
+int spin_lock_claim_unused(bool) { return 0; }
+spin_lock_t* spin_lock_init(uint lock_num)
+{
+    spin_locks[lock_num] = 0;
+    return (spin_lock_t*)&spin_locks[lock_num];
+}
+
+uint32_t spin_lock_blocking(spin_lock_t* lock)
+{
+    std::atomic<uint32_t>* l = (std::atomic<uint32_t>*)lock;
+    uint32_t expected = 0;
+    while (!l->compare_exchange_weak(expected, 1, std::memory_order_acquire))
+        expected = 0;
+    return 0;
+}
+
+void spin_unlock(spin_lock_t* lock, uint32_t) { ((std::atomic<uint32_t>*)lock)->store(0, std::memory_order_release); }
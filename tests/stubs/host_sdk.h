@@ -0,0 +1,86 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Minimal stand-ins for the pico-sdk functions used by the host tested sources
+ *
+ * Time only advances when a test calls host_set_time_us(), hardware is not emulated
+ */
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+#define hard_assert(x)                                                                                                                                         \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(x))                                                                                                                                              \
+            abort();                                                                                                                                           \
+    } while (0)
+
+#define __printflike(fmt_arg, first_arg) __attribute__((format(printf, fmt_arg, first_arg)))
+
+static inline int stdio_putchar(int c) { return c; }
+
+/* Time */
+void host_set_time_us(const uint64_t t);
+uint64_t time_us_64();
+uint32_t time_us_32();
+static inline absolute_time_t from_us_since_boot(const uint64_t t) { return t; }
+static inline absolute_time_t make_timeout_time_us(const uint64_t us) { return time_us_64() + us; }
+static inline bool time_reached(const absolute_time_t t) { return time_us_64() >= t; }
+static inline void sleep_ms(uint32_t) { }
+static inline void sleep_us(uint64_t) { }
+static inline bool best_effort_wfe_or_timeout(const absolute_time_t t) { return time_reached(t); }
+
+/* Sync */
+void __dmb();
+static inline void __sev() { }
+typedef volatile uint32_t spin_lock_t;
+int spin_lock_claim_unused(bool required);
+spin_lock_t* spin_lock_init(uint lock_num);
+uint32_t spin_lock_blocking(spin_lock_t* lock);
+void spin_unlock(spin_lock_t* lock, uint32_t saved_irq);
+
+/* UART */
+typedef struct uart_inst uart_inst_t;
+#define uart1 ((uart_inst_t*)NULL)
+#define UART_PARITY_NONE 0
+#define UART_FUNCSEL_NUM(uart, gpio) 2
+static inline uint uart_init(uart_inst_t*, uint baudrate) { return baudrate; }
+static inline void uart_set_format(uart_inst_t*, uint, uint, int) { }
+static inline void uart_set_hw_flow(uart_inst_t*, bool, bool) { }
+static inline void uart_set_translate_crlf(uart_inst_t*, bool) { }
+static inline void uart_write_blocking(uart_inst_t*, const uint8_t*, size_t) { }
+static inline void gpio_set_function(uint, int) { }
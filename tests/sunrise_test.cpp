@@ -0,0 +1,249 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Equivalence check of the fixed point sunrise renderer against the original floating point one, and a benchmark of both.
+ * Also checks generated/sunrise_keyframes.h against the generator script in its header
+ *
+ * sunrise.cpp is included directly, so that frames can be rendered without going through the cache
+ */
+#include "sunrise.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+/** Largest difference allowed between the fixed point and floating point output, per channel in 8-bit steps */
+#define MAX_CHANNEL_ERROR 1
+
+struct reference_rgb_t
+{
+    float r;
+    float g;
+    float b;
+};
+
+/**
+ * Original get_rgb_from_temp(), in floats
+ */
+static reference_rgb_t reference_rgb_from_temp(float temp)
+{
+    temp = _clamp(temp, float(KELVIN_TABLE_MIN), float(KELVIN_TABLE_MAX));
+
+    const uint32_t t = uint32_t(temp) - KELVIN_TABLE_MIN;
+    uint32_t i = t / KELVIN_TABLE_STEP;
+    uint32_t f = t % KELVIN_TABLE_STEP;
+
+    if (i == KELVIN_TABLE_ENTRIES - 1)
+        i--, f = KELVIN_TABLE_STEP;
+
+    float rgb[3];
+    for (int c = 0; c < 3; c++)
+        rgb[c] = float((kelvin_table[i][c] * (KELVIN_TABLE_STEP - f) + kelvin_table[i + 1][c] * f) / KELVIN_TABLE_STEP) * (1.f / 65280.f);
+
+    return { rgb[0], rgb[1], rgb[2] };
+}
+
+static reference_rgb_t reference_whitepoint;
+
+/**
+ * Original sunrise_apply(), with double precision pow()/sin() and a float gradient
+ */
+static void reference_apply(const float sunrise_factor, led_pixel_t* out, size_t num_pixels)
+{
+    if (sunrise_factor < 0)
+    {
+        memset((void*)out, 0, sizeof(*out) * num_pixels);
+        return;
+    }
+
+    const float temp_bot = 500.f + pow(sunrise_factor, 2.2f) * 3500.f;
+    const float temp_top = temp_bot + sin(sunrise_factor * 3.14159265f) * sin(sunrise_factor * 3.14159265f) * 300.f;
+
+    reference_rgb_t bot = reference_rgb_from_temp(temp_bot);
+    reference_rgb_t top = reference_rgb_from_temp(temp_top);
+
+    const float brightness = _clamp(sunrise_factor * 2.f, 0.f, 1.f);
+    bot = { bot.r * brightness, bot.g * brightness, bot.b * brightness };
+    top = { top.r * brightness, top.g * brightness, top.b * brightness };
+
+    for (size_t i = 0; i < num_pixels; i++)
+    {
+        const float f = float(i) / float(num_pixels - 1);
+        reference_rgb_t c = { bot.r * (1.f - f) + top.r * f, bot.g * (1.f - f) + top.g * f, bot.b * (1.f - f) + top.b * f };
+        c = { _clamp(c.r, 0.f, 1.f), _clamp(c.g, 0.f, 1.f), _clamp(c.b, 0.f, 1.f) };
+
+        const reference_rgb_t& wp = reference_whitepoint;
+        const float w = _clamp((c.r * wp.r + c.g * wp.g + c.b * wp.b) / 3.f, 0.f, 1.f);
+
+        out[i] = led_pack(c.r * 255.f, c.g * 255.f, c.b * 255.f, w * 255.f);
+    }
+}
+
+/**
+ * tanner_helland() from the generator script in generated/sunrise_keyframes.h
+ */
+static void generator_tanner_helland(double temp, double out[3])
+{
+    temp /= 100.0;
+    const double r = temp <= 66 ? 255.0 : 329.698727446 * pow(temp - 60, -0.1332047592);
+    const double g = temp <= 66 ? 99.4708025861 * log(temp) - 161.1195681661 : 288.1221695283 * pow(temp - 60, -0.0755148492);
+    double b;
+    if (temp >= 66)
+        b = 255.0;
+    else if (temp <= 19)
+        b = 0.0;
+    else
+        b = 138.5177312231 * log(temp - 10) - 305.0447927307;
+
+    out[0] = std::min(std::max(r, 0.0), 255.0);
+    out[1] = std::min(std::max(g, 0.0), 255.0);
+    out[2] = std::min(std::max(b, 0.0), 255.0);
+}
+
+/**
+ * Every keyframe against the generator script, rounding half to even like Python's round()
+ */
+static void check_keyframes()
+{
+    for (int i = 0; i <= SUNRISE_KEYFRAME_COUNT; i++)
+    {
+        const double sunrise_factor = double(i) / SUNRISE_KEYFRAME_COUNT;
+        const double temp_bot = 500.0 + pow(sunrise_factor, 2.2) * 3500.0;
+        const double temp_top = temp_bot + pow(sin(sunrise_factor * M_PI), 2) * 300.0;
+        const double brightness = std::min(sunrise_factor * 2.0, 1.0);
+
+        const double temps[2] = { temp_bot, temp_top };
+        for (int stop = 0; stop < 2; stop++)
+        {
+            double rgb[3];
+            generator_tanner_helland(temps[stop], rgb);
+            for (int c = 0; c < 3; c++)
+            {
+                const long expected = lrint(rgb[c] * brightness * 256);
+                CHECK(sunrise_keyframes[i][stop][c] == expected, "Keyframe %d, stop %d, channel %d: %u instead of %ld\n", i, stop, c,
+                    sunrise_keyframes[i][stop][c], expected);
+            }
+        }
+    }
+    printf("Checked %d keyframes against the generator\n", SUNRISE_KEYFRAME_COUNT + 1);
+}
+
+/**
+ * Largest difference between any channel of two pixels
+ */
+static int pixel_difference(const led_pixel_t a, const led_pixel_t b)
+{
+    int r = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+        r = std::max(r, abs(int((a >> shift) & 0xFF) - int((b >> shift) & 0xFF)));
+    return r;
+}
+
+/**
+ * Every Q16 sunrise factor on a full length strip
+ */
+static void check_equivalence()
+{
+    led_pixel_t expected[LED_PIXEL_COUNT];
+    led_pixel_t actual[LED_PIXEL_COUNT];
+
+    int max_error = 0;
+    uint64_t differing = 0;
+    for (int32_t factor = -1; factor <= int32_t(SUNRISE_FACTOR_ONE); factor++)
+    {
+        reference_apply(float(factor) / float(SUNRISE_FACTOR_ONE), expected, LED_PIXEL_COUNT);
+        sunrise_render(factor, actual, LED_PIXEL_COUNT);
+
+        for (size_t i = 0; i < LED_PIXEL_COUNT; i++)
+        {
+            const int error = pixel_difference(expected[i], actual[i]);
+            CHECK(error <= MAX_CHANNEL_ERROR, "Factor %ld, pixel %zu: %08lx instead of %08lx\n", long(factor), i, (unsigned long)actual[i],
+                (unsigned long)expected[i]);
+            max_error = std::max(max_error, error);
+            differing += error != 0;
+        }
+    }
+    printf("Max channel error: %d/255 (%.2f%% of pixels differ)\n", max_error, differing * 100.0 / ((SUNRISE_FACTOR_ONE + 2) * double(LED_PIXEL_COUNT)));
+}
+
+/** Keeps the benchmarked frames from being optimized out */
+static volatile led_pixel_t sink = 0;
+
+/**
+ * Time per frame of both renderers, the host has an FPU so the gap on the RP2040 is much wider
+ */
+static void benchmark()
+{
+    led_pixel_t frame[LED_PIXEL_COUNT];
+    const int32_t step = 7;
+
+    auto start = std::chrono::steady_clock::now();
+    int frames = 0;
+    for (int32_t factor = 0; factor <= int32_t(SUNRISE_FACTOR_ONE); factor += step, frames++)
+    {
+        reference_apply(float(factor) / float(SUNRISE_FACTOR_ONE), frame, LED_PIXEL_COUNT);
+        sink = frame[LED_PIXEL_COUNT / 2];
+    }
+    const double float_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    start = std::chrono::steady_clock::now();
+    for (int32_t factor = 0; factor <= int32_t(SUNRISE_FACTOR_ONE); factor += step)
+    {
+        sunrise_render(factor, frame, LED_PIXEL_COUNT);
+        sink = frame[LED_PIXEL_COUNT / 2];
+    }
+    const double fixed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    printf("Floating point: %8.1f ns per %d pixel frame\n", float_ns, LED_PIXEL_COUNT);
+    printf("Fixed point:    %8.1f ns per %d pixel frame\n", fixed_ns, LED_PIXEL_COUNT);
+}
+
+int main()
+{
+    sunrise_init(LED_WHITE_COLOR_TEMP);
+    reference_whitepoint = reference_rgb_from_temp(LED_WHITE_COLOR_TEMP);
+
+    check_keyframes();
+    check_equivalence();
+    benchmark();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,231 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Check of the POSIX TZ rules engine against the C library's handling of the same TZ strings
+ */
+#include "timezone.h"
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+microseconds_t get_unix_time() { return 0; }
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+/** TZ strings that the C library and timezone_t must agree on */
+static const char* const zones[] = {
+    "AKST9AKDT,M3.2.0,M11.1.0",
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    /* Southern hemisphere */
+    "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    "NZST-12NZDT,M9.5.0,M4.1.0/3",
+    /* Half hour offsets, east and west of Greenwich */
+    "IST-5:30",
+    "NST3:30NDT,M3.2.0,M11.1.0",
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0",
+    /* Julian days with and without February 29th */
+    "XST3XDT,J60/1:30,J300/1:30",
+    "XST3XDT,59/1:30,299/1:30",
+    /* Transition times outside of [0, 24] hours */
+    "<-03>3<-02>,M3.5.0/-2,M10.5.0/-1",
+    "IST-2IDT,M3.4.4/26,M10.5.0",
+    "<-0230>2:30<-0130>,M3.2.0/-1:30,M11.1.0/26:30",
+    /* No daylight savings */
+    "UTC0",
+    "<-11>11",
+};
+
+/** First and last UTC years checked */
+#define FIRST_YEAR 1970
+#define LAST_YEAR 2100
+
+struct expected_t
+{
+    long offset;
+    bool dst;
+    char name[TIMEZONE_NAME_MAX + 1];
+};
+
+static expected_t get_expected(const time_t t)
+{
+    struct tm tm = {};
+    localtime_r(&t, &tm);
+
+    expected_t r;
+    r.offset = tm.tm_gmtoff;
+    r.dst = tm.tm_isdst > 0;
+    snprintf(r.name, sizeof(r.name), "%s", tm.tm_zone);
+    return r;
+}
+
+/**
+ * Compare a single point in time
+ */
+static void check_time(const char* zone, const timezone_t& tz, const time_t t, const expected_t& expected)
+{
+    const datetime_t utc(microseconds_t(t) * MICROSECONDS_PER_SECOND);
+    const microseconds_t offset = tz.get_offset(utc).to_microseconds_since_1970();
+
+    CHECK(offset == expected.offset * MICROSECONDS_PER_SECOND && tz.is_dst(utc) == expected.dst && strcmp(tz.get_name(utc), expected.name) == 0,
+        "%s at %lld: offset %lld s, dst %d, %s instead of offset %ld s, dst %d, %s\n", zone, (long long)t, (long long)(offset / MICROSECONDS_PER_SECOND),
+        tz.is_dst(utc), tz.get_name(utc), expected.offset, expected.dst, expected.name);
+
+    /* Local times repeated at the end of daylight savings time resolve to their first occurrence */
+    const datetime_t local = tz.to_local(utc);
+    datetime_t first = utc;
+    for (const microseconds_t back : { 30 * MICROSECONDS_PER_MINUTE, MICROSECONDS_PER_HOUR })
+    {
+        const datetime_t earlier = utc - timespan_t(back);
+        if (tz.to_local(earlier).to_microseconds_since_1970() == local.to_microseconds_since_1970())
+            first = earlier;
+    }
+    CHECK(tz.to_utc(local).to_microseconds_since_1970() == first.to_microseconds_since_1970(), "%s at %lld: to_utc() round trip\n", zone, (long long)t);
+}
+
+/**
+ * Sweep every zone in 3 hour steps, checking the exact second of every transition found along the way
+ */
+static void check_sweep(const char* zone, const timezone_t& tz)
+{
+    const time_t first = time_t(days_from_civil(FIRST_YEAR, 1, 1)) * 86400;
+    const time_t last = time_t(days_from_civil(LAST_YEAR + 1, 1, 1)) * 86400;
+    const time_t step = 3 * 3600;
+
+    uint32_t transitions = 0;
+    expected_t prev = get_expected(first);
+    for (time_t t = first; t < last; t += step)
+    {
+        const expected_t cur = get_expected(t);
+        check_time(zone, tz, t, cur);
+
+        if (t != first && (cur.offset != prev.offset || cur.dst != prev.dst))
+        {
+            /* Find the first second of the new offset */
+            time_t lo = t - step, hi = t;
+            while (hi - lo > 1)
+            {
+                const time_t mid = lo + (hi - lo) / 2;
+                const expected_t e = get_expected(mid);
+                (e.offset == cur.offset && e.dst == cur.dst ? hi : lo) = mid;
+            }
+            check_time(zone, tz, lo, get_expected(lo));
+            check_time(zone, tz, hi, get_expected(hi));
+            transitions++;
+        }
+        prev = cur;
+    }
+
+    printf("%-48s %u transitions\n", zone, transitions);
+}
+
+/**
+ * Random points in time, so that consecutive conversions land in different years of the transition cache
+ */
+static void check_random(const char* zone, const timezone_t& tz)
+{
+    const time_t first = time_t(days_from_civil(FIRST_YEAR, 1, 1)) * 86400;
+    const time_t last = time_t(days_from_civil(LAST_YEAR + 1, 1, 1)) * 86400;
+
+    std::mt19937_64 rng(1);
+    std::uniform_int_distribution<time_t> dist(first, last - 1);
+    for (int i = 0; i < 100000; i++)
+    {
+        const time_t t = dist(rng);
+        check_time(zone, tz, t, get_expected(t));
+    }
+}
+
+/**
+ * Malformed strings are rejected, and leave the timezone unchanged
+ */
+static void check_malformed()
+{
+    static const char* const malformed[] = {
+        "",
+        "EST",
+        "ES5",
+        "EST5EDT,M3.2.0",
+        "EST5EDT,M13.2.0,M11.1.0",
+        "EST5EDT,M3.6.0,M11.1.0",
+        "EST5EDT,M3.2.7,M11.1.0",
+        "EST5EDT,J0,J365",
+        "EST5EDT,366,0",
+        "EST25",
+        "EST5:60",
+        "<EST5",
+        "EST5EDT,M3.2.0,M11.1.0x",
+        "EST5EDT,M3.2.0/168,M11.1.0",
+    };
+
+    timezone_t tz;
+    CHECK(tz.parse("CET-1CEST,M3.5.0,M10.5.0/3"), "Valid string rejected\n");
+    for (const char* rule : malformed)
+    {
+        CHECK(!tz.parse(rule), "\"%s\" accepted\n", rule);
+        CHECK(strcmp(tz.get_name(datetime_t(0)), "CET") == 0, "\"%s\" changed the timezone\n", rule);
+    }
+
+    /* The rules default to the current US ones */
+    timezone_t defaulted, explicit_rules;
+    CHECK(defaulted.parse("EST5EDT") && explicit_rules.parse("EST5EDT,M3.2.0/2,M11.1.0/2"), "Default rules rejected\n");
+    for (int64_t t = 0; t < 100ll * 365 * 86400; t += 3600)
+    {
+        const datetime_t utc(t * MICROSECONDS_PER_SECOND);
+        CHECK(defaulted.is_dst(utc) == explicit_rules.is_dst(utc), "Default rules differ at %lld\n", (long long)t);
+    }
+}
+
+int main()
+{
+    for (const char* zone : zones)
+    {
+        setenv("TZ", zone, 1);
+        tzset();
+
+        timezone_t tz;
+        CHECK(tz.parse(zone), "%s rejected\n", zone);
+
+        check_sweep(zone, tz);
+        check_random(zone, tz);
+    }
+    check_malformed();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief Simulation of the clock discipline loop against a mistuned crystal, checking that unix time never runs backwards across a sync
+ * and that the frequency estimate survives a long holdover. Also benchmarks get_unix_time() latency while another thread syncs the clock
+ */
+#include "unix_time.h"
+
+#include "hardware/timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+static uint32_t failures = 0;
+
+#define CHECK(cond, ...)                                                                                                                                       \
+    do                                                                                                                                                         \
+    {                                                                                                                                                          \
+        if (!(cond) && failures++ < 10)                                                                                                                        \
+            printf(__VA_ARGS__);                                                                                                                               \
+    } while (0)
+
+/** Local crystal error, the local clock runs fast by this much */
+#define CRYSTAL_PPM 40.0
+/** Unix time of the first simulated second */
+#define START_UNIX (microseconds_t(1700000000) * MICROSECONDS_PER_SECOND)
+
+static microseconds_t last_read = 0;
+
+/**
+ * Advance local time to `t` in `step` microsecond increments, reading the clock at every step
+ */
+static void advance(const uint64_t t, const uint64_t step)
+{
+    for (uint64_t now = time_us_64(); now < t;)
+    {
+        now = now + step < t ? now + step : t;
+        host_set_time_us(now);
+        const microseconds_t r = get_unix_time();
+        CHECK(r >= last_read, "Clock ran backwards by %lld us at local time %llu\n", (long long)(last_read - r), (unsigned long long)now);
+        last_read = r;
+    }
+}
+
+/**
+ * Sync once per second with jittered measurements that arrive up to 300 ms late, reading the clock at every microsecond around each sync
+ *
+ * Once the loop has settled, one measurement is offset by 60 ms so that the clock slews backwards at the maximum rate
+ */
+static void check_discipline()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> jitter(-20.0, 20.0);
+    std::uniform_int_distribution<uint64_t> delay(1000, 300 * 1000);
+
+    init_unix_time();
+    host_set_time_us(1);
+
+    const int seconds = 4 * 3600;
+    const int disturbed = 600;
+    double max_error = 0;
+    for (int i = 1; i <= seconds; i++)
+    {
+        const double truth_local = i * MICROSECONDS_PER_SECOND * (1.0 + CRYSTAL_PPM * 1e-6);
+        const uint64_t local_time = uint64_t(llround(truth_local + jitter(rng)));
+        const uint64_t arrival = local_time + delay(rng);
+        microseconds_t measurement = START_UNIX + i * MICROSECONDS_PER_SECOND;
+        if (i == disturbed)
+            measurement -= 60 * 1000;
+
+        advance(arrival - 1000, 997);
+        advance(arrival, 1);
+        sync_unix_time(measurement, local_time);
+        /* The first sync steps the clock */
+        if (i == 1)
+            last_read = get_unix_time();
+        advance(arrival + 1000, 1);
+
+        /* Error against the true time */
+        if (i > seconds - 3600)
+        {
+            const double truth = START_UNIX + time_us_64() / (1.0 + CRYSTAL_PPM * 1e-6);
+            max_error = fmax(max_error, fabs(get_unix_time() - truth));
+        }
+    }
+
+    const unix_time_stats_t stats = get_unix_time_stats();
+    printf("Frequency correction: %.3f ppm (Crystal %.1f ppm fast)\n", stats.frequency_ppm, CRYSTAL_PPM);
+    printf("Max |error| in the last hour: %.1f us\n", max_error);
+    printf("Syncs: %lu, steps: %lu, rejections: %lu\n", (unsigned long)stats.syncs, (unsigned long)stats.steps, (unsigned long)stats.rejections);
+    CHECK(fabs(stats.frequency_ppm + CRYSTAL_PPM) < 1.0, "Frequency correction did not converge\n");
+    CHECK(max_error < 50.0, "Phase did not converge\n");
+    CHECK(stats.steps == 1 && stats.rejections == 0, "Unexpected steps or rejections\n");
+}
+
+/**
+ * Time batches of reads, and check that every read is within `tolerance` of `expected`
+ *
+ * @returns Duration of each batch in nanoseconds
+ */
+static std::vector<double> time_reads(const microseconds_t expected, const microseconds_t tolerance)
+{
+    const int batches = 20000;
+    const int batch_size = 64;
+    std::vector<double> r;
+    r.reserve(batches);
+    for (int i = 0; i < batches; i++)
+    {
+        microseconds_t values[batch_size];
+        const auto start = std::chrono::steady_clock::now();
+        for (int j = 0; j < batch_size; j++)
+            values[j] = get_unix_time();
+        r.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / batch_size);
+
+        for (int j = 0; j < batch_size; j++)
+            CHECK(llabs(values[j] - expected) <= tolerance, "Torn read: %lld us off\n", (long long)(values[j] - expected));
+    }
+    std::sort(r.begin(), r.end());
+    return r;
+}
+
+static void print_latency(const char* label, const std::vector<double>& batches)
+{
+    double sum = 0;
+    for (const double b : batches)
+        sum += b;
+    printf("%s mean %.1f ns, p99 %.1f ns, max %.1f ns (Per read, batches of 64)\n", label, sum / batches.size(), batches[batches.size() * 99 / 100],
+        batches.back());
+}
+
+/**
+ * Read latency with and without a writer syncing the clock as fast as it can
+ *
+ * Local time is frozen, so every consistent read returns the synced time
+ */
+static void benchmark_contention()
+{
+    const uint64_t local = 10 * MICROSECONDS_PER_SECOND;
+    const microseconds_t expected = START_UNIX + local;
+
+    host_set_time_us(local);
+    set_unix_time(expected);
+
+    print_latency("Uncontended:", time_reads(expected, 0));
+
+    std::atomic<bool> stop { false };
+    std::atomic<uint32_t> writes { 0 };
+    std::thread writer([&] {
+        for (uint32_t i = 0; !stop; i++)
+        {
+            sync_unix_time(expected + ((i & 1) ? 10 : -10), local);
+            writes++;
+        }
+    });
+    /* The first sync steps the clock 10 us back, after that syncs are rebased at the frozen present so no slew is ever applied */
+    const std::vector<double> contended = time_reads(expected, 10);
+    stop = true;
+    writer.join();
+
+    print_latency("Contended:  ", contended);
+    printf("Syncs during contended reads: %lu\n", (unsigned long)writes.load());
+}
+
+/**
+ * Frequency estimate after a 100 day holdover with a crystal 400 ppm fast
+ *
+ * The drift over the holdover is about 2^31.7 microseconds, which must not overflow when it is scaled up to Q32
+ */
+static void check_holdover()
+{
+    const double crystal_ppm = 400.0;
+    const double crystal = 1.0 + crystal_ppm * 1e-6;
+
+    set_unix_time(0);
+    uint64_t local = time_us_64();
+    const uint64_t local_start = local;
+
+    /* Long enough for the frequency estimate to settle well below the accuracy that the holdover needs */
+    for (int i = 0; i < 12 * 3600; i++)
+    {
+        local += MICROSECONDS_PER_SECOND;
+        host_set_time_us(local);
+        sync_unix_time(START_UNIX + microseconds_t(llround((local - local_start) / crystal)), local);
+    }
+    const unix_time_stats_t before = get_unix_time_stats();
+
+    local += 100 * MICROSECONDS_PER_DAY;
+    for (int i = 0; i < 10; i++)
+    {
+        local += MICROSECONDS_PER_SECOND;
+        host_set_time_us(local);
+        sync_unix_time(START_UNIX + microseconds_t(llround((local - local_start) / crystal)), local);
+    }
+    const unix_time_stats_t after = get_unix_time_stats();
+
+    printf("Holdover: frequency correction %.4f ppm before, %.4f ppm after, phase error %lld us\n", before.frequency_ppm, after.frequency_ppm,
+        (long long)after.phase_error);
+    /* The correction is relative to local time, so a crystal 400 ppm fast needs a correction of 1 / 1.0004 - 1 */
+    const double expected_ppm = (1.0 / crystal - 1.0) * 1e6;
+    CHECK(fabs(before.frequency_ppm - expected_ppm) < 0.01 && fabs(after.frequency_ppm - expected_ppm) < 0.01, "Frequency estimate broke after the holdover\n");
+    CHECK(after.steps == before.steps && after.rejections == before.rejections && std::abs(after.phase_error) < 1000,
+        "Holdover: %lu steps, %lu rejections, phase error %lld us\n", (unsigned long)(after.steps - before.steps),
+        (unsigned long)(after.rejections - before.rejections), (long long)after.phase_error);
+}
+
+int main()
+{
+    check_discipline();
+    check_holdover();
+    benchmark_contention();
+
+    printf("%lu failures\n", (unsigned long)failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
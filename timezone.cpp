@@ -0,0 +1,250 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief POSIX TZ style timezone rules (Implementation)
+ */
+#include "timezone.h"
+
+#include <ctype.h>
+#include <string.h>
+
+int32_t timezone_rule_t::get_day(const int32_t year) const
+{
+    const int32_t jan_1 = days_from_civil(year, 1, 1);
+    switch (type)
+    {
+    case TIMEZONE_RULE_MONTH_WEEK_DAY:
+        return nth_weekday_of_month(year, month, week, weekday);
+    case TIMEZONE_RULE_JULIAN_NO_LEAP:
+    {
+        const bool is_leap_year = days_from_civil(year, 3, 1) - jan_1 == 60;
+        return jan_1 + day - 1 + (is_leap_year && day >= 60);
+    }
+    case TIMEZONE_RULE_JULIAN:
+    default:
+        return jan_1 + day;
+    }
+}
+
+/**
+ * Parse a timezone abbreviation
+ *
+ * @returns Pointer to the character after the name, or NULL on error
+ */
+static const char* parse_name(const char* s, char* out)
+{
+    size_t len = 0;
+    const bool quoted = *s == '<';
+    if (quoted)
+    {
+        s++;
+        while (s[len] && s[len] != '>')
+            len++;
+        if (s[len] != '>')
+            return NULL;
+    }
+    else
+    {
+        while (isalpha((unsigned char)s[len]))
+            len++;
+    }
+
+    if (len < 3 || len > TIMEZONE_NAME_MAX)
+        return NULL;
+
+    memcpy(out, s, len);
+    out[len] = '\0';
+
+    return s + len + quoted;
+}
+
+/**
+ * Parse an unsigned decimal number
+ *
+ * @returns Pointer to the character after the number, or NULL if there are no digits or the number exceeds `max`
+ */
+static const char* parse_number(const char* s, int32_t& out, const int32_t max)
+{
+    if (!isdigit((unsigned char)*s))
+        return NULL;
+
+    out = 0;
+    while (isdigit((unsigned char)*s))
+    {
+        out = out * 10 + (*s++ - '0');
+        if (out > max)
+            return NULL;
+    }
+
+    return s;
+}
+
+/**
+ * Parse a time/offset in the format `[+-]hh[:mm[:ss]]`
+ *
+ * @param max_hours Maximum number of hours (24 for offsets, 167 for transition times)
+ * @param out Seconds
+ *
+ * @returns Pointer to the character after the time, or NULL on error
+ */
+static const char* parse_time(const char* s, const int32_t max_hours, int32_t& out)
+{
+    const bool negative = *s == '-';
+    if (*s == '-' || *s == '+')
+        s++;
+
+    int32_t hours = 0, minutes = 0, seconds = 0;
+    s = parse_number(s, hours, max_hours);
+    if (s && *s == ':')
+        s = parse_number(s + 1, minutes, 59);
+    if (s && *s == ':')
+        s = parse_number(s + 1, seconds, 59);
+    if (!s)
+        return NULL;
+
+    out = hours * 3600 + minutes * 60 + seconds;
+    if (negative)
+        out = -out;
+
+    return s;
+}
+
+/**
+ * Parse a transition rule in the format `start[/time]`
+ *
+ * @returns Pointer to the character after the rule, or NULL on error
+ */
+static const char* parse_rule(const char* s, timezone_rule_t& rule)
+{
+    int32_t val = 0;
+    rule = {};
+    if (*s == 'M')
+    {
+        rule.type = timezone_rule_t::TIMEZONE_RULE_MONTH_WEEK_DAY;
+        s = parse_number(s + 1, val, 12);
+        if (!s || val < 1 || *s != '.')
+            return NULL;
+        rule.month = val;
+        s = parse_number(s + 1, val, 5);
+        if (!s || val < 1 || *s != '.')
+            return NULL;
+        rule.week = val;
+        s = parse_number(s + 1, val, 6);
+        if (!s)
+            return NULL;
+        rule.weekday = val;
+    }
+    else if (*s == 'J')
+    {
+        rule.type = timezone_rule_t::TIMEZONE_RULE_JULIAN_NO_LEAP;
+        s = parse_number(s + 1, val, 365);
+        if (!s || val < 1)
+            return NULL;
+        rule.day = val;
+    }
+    else
+    {
+        rule.type = timezone_rule_t::TIMEZONE_RULE_JULIAN;
+        s = parse_number(s, val, 365);
+        if (!s)
+            return NULL;
+        rule.day = val;
+    }
+
+    rule.time = 2 * 3600;
+    if (*s == '/')
+        s = parse_time(s + 1, 167, rule.time);
+
+    return s;
+}
+
+bool timezone_t::parse(const char* rule)
+{
+    timezone_t tz;
+    int32_t offset = 0;
+
+    const char* s = parse_name(rule, tz.std_name);
+    if (s)
+        s = parse_time(s, 24, offset);
+    if (!s)
+        return false;
+
+    /* POSIX offsets are positive west of Greenwich */
+    tz.std_offset = -offset * MICROSECONDS_PER_SECOND;
+
+    if (*s)
+    {
+        tz.has_dst = true;
+        s = parse_name(s, tz.dst_name);
+        if (!s)
+            return false;
+
+        tz.dst_offset = tz.std_offset + MICROSECONDS_PER_HOUR;
+        if (*s && *s != ',')
+        {
+            s = parse_time(s, 24, offset);
+            if (!s)
+                return false;
+            tz.dst_offset = -offset * MICROSECONDS_PER_SECOND;
+        }
+
+        if (!*s)
+            s = ",M3.2.0,M11.1.0";
+
+        if (*s != ',' || !(s = parse_rule(s + 1, tz.dst_start)) || *s != ',' || !(s = parse_rule(s + 1, tz.dst_end)))
+            return false;
+    }
+
+    if (*s)
+        return false;
+
+    *this = tz;
+
+    return true;
+}
+
+void timezone_t::update_cache(const microseconds_t utc) const
+{
+    microseconds_t days = utc / MICROSECONDS_PER_DAY;
+    if (utc % MICROSECONDS_PER_DAY < 0)
+        days--;
+    const int32_t year = civil_from_days(days).year;
+
+    cache_begin = days_from_civil(year, 1, 1) * MICROSECONDS_PER_DAY;
+    cache_end = days_from_civil(year + 1, 1, 1) * MICROSECONDS_PER_DAY;
+
+    /* Transition times are in the local time in effect before the transition */
+    const microseconds_t start = dst_start.get_day(year) * MICROSECONDS_PER_DAY + dst_start.time * MICROSECONDS_PER_SECOND - std_offset;
+    const microseconds_t end = dst_end.get_day(year) * MICROSECONDS_PER_DAY + dst_end.time * MICROSECONDS_PER_SECOND - dst_offset;
+
+    /* Southern hemisphere: Daylight savings time spans new years, so standard time is the interval in the middle of the year */
+    cache_inverted = end < start;
+    cache_dst_start = cache_inverted ? end : start;
+    cache_dst_end = cache_inverted ? start : end;
+}
@@ -0,0 +1,158 @@
+/**
+ * pico-sunrise - A sunrise clock for RP2040 based microcontrollers
+ *
+ * @file
+ * @copyright
+ * @parblock
+ * SPDX-License-Identifier: MIT
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2025 Ian Hangartner <icrashstuff at outlook dot com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ * @endparblock
+ *
+ * @brief POSIX TZ style timezone rules
+ */
+#pragma once
+
+#include "datetime.h"
+
+/** Maximum length of a timezone abbreviation (eg. "AKST") */
+#define TIMEZONE_NAME_MAX 15
+
+/**
+ * Daylight savings time transition rule
+ */
+struct timezone_rule_t
+{
+    enum type_t : uint8_t
+    {
+        /** `Mm.w.d`: Day `d` (0 is Sunday) of week `w` (5 is the last) of month `m` */
+        TIMEZONE_RULE_MONTH_WEEK_DAY,
+        /** `Jn`: Day `n` of the year in the range [1,365], February 29th is never counted */
+        TIMEZONE_RULE_JULIAN_NO_LEAP,
+        /** `n`: Day `n` of the year in the range [0,365], February 29th is counted */
+        TIMEZONE_RULE_JULIAN,
+    };
+
+    type_t type;
+    uint8_t month;
+    uint8_t week;
+    uint8_t weekday;
+    uint16_t day;
+    /** Local time of the transition in seconds since midnight (May be negative or past 24 hours) */
+    int32_t time;
+
+    /**
+     * Get number of days since 1970-01-01 of the day the transition occurs on in `year`
+     */
+    int32_t get_day(const int32_t year) const;
+};
+
+/**
+ * Timezone described by a POSIX TZ string (eg. "AKST9AKDT,M3.2.0,M11.1.0")
+ *
+ * The daylight savings transitions of the year being converted are cached, so most conversions are two comparisons
+ *
+ * @note The cache is keyed on the UTC year, so rules with transitions within a day of new years may be off by an hour around that transition
+ */
+struct timezone_t
+{
+    /**
+     * Parse a POSIX TZ string
+     *
+     * Format: `std offset[dst[offset][,start[/time],end[/time]]]`
+     * - Names are at least 3 letters, or any characters enclosed in `<>` (eg. "<+10>")
+     * - Offsets are `[+-]hh[:mm[:ss]]`, and are positive west of Greenwich
+     * - The daylight savings offset defaults to an hour ahead of standard time
+     * - Transition times default to 02:00:00 local time, the rules default to "M3.2.0,M11.1.0"
+     *
+     * Southern hemisphere zones (where daylight savings time ends earlier in the year than it starts) are supported
+     *
+     * @returns True on success, false if `rule` is malformed (the timezone is left unchanged)
+     */
+    bool parse(const char* rule);
+
+    /**
+     * Check if daylight savings time is in effect at a point in time
+     */
+    inline bool is_dst(const datetime_t& utc) const
+    {
+        const microseconds_t t = utc.to_microseconds_since_1970();
+        if (!has_dst)
+            return false;
+        if (t < cache_begin || t >= cache_end)
+            update_cache(t);
+        return (cache_dst_start <= t && t < cache_dst_end) != cache_inverted;
+    }
+
+    /**
+     * Get offset from UTC to local time at a point in time
+     */
+    inline timespan_t get_offset(const datetime_t& utc) const { return is_dst(utc) ? dst_offset : std_offset; }
+
+    /**
+     * Get offset from UTC to local standard time
+     */
+    inline timespan_t get_std_offset() const { return std_offset; }
+
+    /**
+     * Get abbreviation of the local time in effect at a point in time
+     */
+    inline const char* get_name(const datetime_t& utc) const { return is_dst(utc) ? dst_name : std_name; }
+
+    /**
+     * Convert a UTC time to local time
+     */
+    inline datetime_t to_local(const datetime_t& utc) const { return utc + get_offset(utc); }
+
+    /**
+     * Convert a local time to UTC
+     *
+     * Times repeated when daylight savings time ends resolve to their first occurrence,
+     * times skipped when it starts are pushed forward by the length of the gap
+     */
+    inline datetime_t to_utc(const datetime_t& local) const
+    {
+        if (has_dst && is_dst(local - timespan_t(dst_offset)))
+            return local - timespan_t(dst_offset);
+        return local - timespan_t(std_offset);
+    }
+
+private:
+    /**
+     * Compute the transitions of the UTC year containing `utc`
+     */
+    void update_cache(const microseconds_t utc) const;
+
+    char std_name[TIMEZONE_NAME_MAX + 1] = "UTC";
+    char dst_name[TIMEZONE_NAME_MAX + 1] = "";
+    microseconds_t std_offset = 0;
+    microseconds_t dst_offset = 0;
+    bool has_dst = false;
+    timezone_rule_t dst_start = {};
+    timezone_rule_t dst_end = {};
+
+    mutable microseconds_t cache_begin = 0;
+    mutable microseconds_t cache_end = 0;
+    /** When inverted (southern hemisphere) this is actually the start of standard time */
+    mutable microseconds_t cache_dst_start = 0;
+    mutable microseconds_t cache_dst_end = 0;
+    mutable bool cache_inverted = false;
+};
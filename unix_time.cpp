@@ -31,31 +31,192 @@
  */
 #include "unix_time.h"
 
+#include "hardware/sync.h"
 #include "hardware/timer.h"
-#include "pico/mutex.h"
+#include "seqlock.h"
 
-static mutex_t lock = {};
+/** Parameters mapping local time to unix time */
+struct clock_params_t
+{
+    /** Local time at which the clock was last rebased */
+    uint64_t base_local;
+    /** Unix time at `base_local` */
+    microseconds_t base_unix;
+    /** Frequency correction, as a signed Q32 fraction of elapsed local time */
+    int64_t rate;
+    /** Phase correction to slew in since `base_local` */
+    microseconds_t slew;
+};
+
+/** Serializes writers, readers go through the seqlocks instead */
+static spin_lock_t* write_lock = NULL;
+
+static seqlock_t<clock_params_t> published_params = {};
+static seqlock_t<unix_time_stats_t> published_stats = {};
+
+/** Writer's copy of the parameters (Write lock must be held) */
+static clock_params_t params = {};
+
+/** Measurement the frequency error is estimated against */
+static uint64_t anchor_local = 0;
+static microseconds_t anchor_unix = 0;
+
+/** Number of consecutive outliers */
+static uint32_t outliers = 0;
+
+static unix_time_stats_t stats = {};
+
+#define Q32_PER_PPM ((int64_t(1) << 32) / 1000000)
+
+/**
+ * Multiply by a signed Q32 fraction
+ *
+ * `b` must be within [-2^32, 2^32]
+ */
+static int64_t mul_q32(const int64_t a, const int64_t b)
+{
+    const uint64_t ua = a < 0 ? -a : a;
+    const uint64_t ub = b < 0 ? -b : b;
+    const uint64_t r = (ua >> 32) * ub + (((ua & 0xFFFFFFFF) * ub) >> 32);
+    return ((a < 0) != (b < 0)) ? -int64_t(r) : int64_t(r);
+}
+
+/**
+ * Get the part of `p.slew` applied after `elapsed` microseconds since `p.base_local`
+ */
+static microseconds_t slew_applied(const clock_params_t& p, const int64_t elapsed)
+{
+    if (elapsed <= 0)
+        return 0;
+    const microseconds_t max_slew = elapsed * CLOCK_MAX_SLEW_PPM / 1000000;
+    return p.slew > max_slew ? max_slew : (p.slew < -max_slew ? -max_slew : p.slew);
+}
+
+/**
+ * Get unix time at a local time
+ */
+static microseconds_t unix_time_at(const clock_params_t& p, const uint64_t local)
+{
+    const int64_t elapsed = local - p.base_local;
+    return p.base_unix + elapsed + mul_q32(elapsed, p.rate) + slew_applied(p, elapsed);
+}
+
+/**
+ * Jump to a time (Write lock must be held)
+ */
+static void step(const microseconds_t t, const uint64_t local)
+{
+    params.base_unix = t;
+    params.base_local = local;
+    params.slew = 0;
+    anchor_unix = t;
+    anchor_local = local;
+    outliers = 0;
+}
 
-static microseconds_t offset = 0;
+/**
+ * Publish `params` and `stats` to readers, then release the write lock
+ */
+static void publish_and_unlock(const uint32_t irq_state)
+{
+    published_params.write(params);
+    published_stats.write(stats);
+    spin_unlock(write_lock, irq_state);
+}
 
 microseconds_t get_unix_time()
 {
-    microseconds_t r = 0;
-    mutex_enter_blocking(&lock);
-    r = time_us_64() + offset;
-    mutex_exit(&lock);
-    return r;
+    const clock_params_t p = published_params.read();
+    return unix_time_at(p, time_us_64());
 }
 
 void set_unix_time(const microseconds_t microseconds_since_1970)
 {
-    mutex_enter_blocking(&lock);
-    offset = microseconds_since_1970 - microseconds_t(time_us_64());
-    mutex_exit(&lock);
+    const uint32_t irq_state = spin_lock_blocking(write_lock);
+    step(microseconds_since_1970, time_us_64());
+    stats.synced = false;
+    publish_and_unlock(irq_state);
+}
+
+microseconds_t sync_unix_time(const microseconds_t microseconds_since_1970, const uint64_t local_time)
+{
+    const uint32_t irq_state = spin_lock_blocking(write_lock);
+
+    const microseconds_t predicted = unix_time_at(params, local_time);
+    const microseconds_t error = predicted - microseconds_since_1970;
+    stats.phase_error = error;
+
+    const bool outlier = error > CLOCK_STEP_THRESHOLD || error < -CLOCK_STEP_THRESHOLD;
+    if (stats.synced && outlier && ++outliers < CLOCK_STEP_OUTLIER_COUNT)
+    {
+        stats.rejections++;
+        publish_and_unlock(irq_state);
+        return error;
+    }
+    if (!outlier)
+        outliers = 0;
+
+    stats.syncs++;
+    stats.last_sync = local_time;
+
+    /* Either the first sync, or the outliers have persisted long enough that the clock must be wrong */
+    if (!stats.synced || outlier)
+    {
+        step(microseconds_since_1970, local_time);
+        stats.steps++;
+        stats.synced = true;
+        publish_and_unlock(irq_state);
+        return error;
+    }
+
+    /* Rebase at the present so the clock stays continuous for readers, then slew out part of the error from there */
+    const uint64_t now = time_us_64();
+    params.base_unix = unix_time_at(params, now);
+    params.base_local = now;
+    params.slew = -(error >> CLOCK_PHASE_GAIN_SHIFT);
+
+    /* Measure the frequency error over a long baseline so that measurement jitter averages out */
+    const int64_t baseline = local_time - anchor_local;
+    if (baseline >= int64_t(CLOCK_FREQUENCY_INTERVAL) * MICROSECONDS_PER_SECOND)
+    {
+        /* Scale down long baselines (eg. after a holdover) so that the drift fits in 31 bits before it is shifted up to Q32,
+         * the drift is also clamped to 1/256 of the baseline, which is well past CLOCK_MAX_FREQUENCY_PPM */
+        int64_t drift = (microseconds_since_1970 - anchor_unix) - baseline;
+        int64_t scaled_baseline = baseline;
+        while (scaled_baseline >= (int64_t(1) << 31))
+            drift /= 2, scaled_baseline /= 2;
+        const int64_t max_drift = scaled_baseline >> 8;
+        drift = drift > max_drift ? max_drift : (drift < -max_drift ? -max_drift : drift);
+
+        const int64_t measured = drift * (int64_t(1) << 32) / scaled_baseline;
+        params.rate += (measured - params.rate) >> 2;
+
+        const int64_t max_rate = CLOCK_MAX_FREQUENCY_PPM * Q32_PER_PPM;
+        params.rate = params.rate > max_rate ? max_rate : (params.rate < -max_rate ? -max_rate : params.rate);
+
+        anchor_unix = microseconds_since_1970;
+        anchor_local = local_time;
+    }
+
+    publish_and_unlock(irq_state);
+    return error;
+}
+
+unix_time_stats_t get_unix_time_stats()
+{
+    const clock_params_t p = published_params.read();
+    unix_time_stats_t r = published_stats.read();
+    r.frequency_ppm = p.rate * 1e6f / 4294967296.0f;
+    r.slew_remaining = p.slew - slew_applied(p, time_us_64() - p.base_local);
+    return r;
 }
 
 void init_unix_time()
 {
-    mutex_init(&lock);
-    offset = 0;
+    write_lock = spin_lock_init(spin_lock_claim_unused(true));
+
+    const uint32_t irq_state = spin_lock_blocking(write_lock);
+    params = {};
+    step(0, 0);
+    publish_and_unlock(irq_state);
 }
@@ -33,6 +33,8 @@
 
 #include <stdint.h>
 
+#include "config.h"
+
 #define MICROSECONDS_PER_SECOND (microseconds_t(1000ll * 1000ll))
 #define MICROSECONDS_PER_MINUTE (microseconds_t(60ll * MICROSECONDS_PER_SECOND))
 #define MICROSECONDS_PER_HOUR (microseconds_t(60ll * MICROSECONDS_PER_MINUTE))
@@ -43,16 +45,61 @@ typedef int64_t microseconds_t;
 /**
  * Gets current unix time
  *
+ * Lock-free, safe to call from either core and from interrupts
+ *
  * @returns Microseconds since 1970
  */
 microseconds_t get_unix_time();
 
 /**
- * Sets unix time
+ * Sets unix time immediately
+ *
+ * The frequency correction is kept, and the next call to sync_unix_time() steps the clock
  */
 void set_unix_time(const microseconds_t microseconds_since_1970);
 
 /**
- * Initializes internal mutex
+ * Feed a time measurement to the clock discipline loop
+ *
+ * The first measurement steps the clock. After that, phase errors are slewed out at up to @ref CLOCK_MAX_SLEW_PPM,
+ * and the frequency error of the local clock is estimated every @ref CLOCK_FREQUENCY_INTERVAL seconds,
+ * so that the clock keeps time between measurements (and through GPS outages).
+ * Phase errors larger than @ref CLOCK_STEP_THRESHOLD are rejected as outliers,
+ * unless there are @ref CLOCK_STEP_OUTLIER_COUNT of them in a row, in which case the clock is stepped.
+ *
+ * @param microseconds_since_1970 Unix time at `local_time`
+ * @param local_time Value of `time_us_64()` that `microseconds_since_1970` corresponds to
+ *
+ * @returns Phase error, how far ahead of `microseconds_since_1970` the clock was at `local_time`
+ */
+microseconds_t sync_unix_time(const microseconds_t microseconds_since_1970, const uint64_t local_time);
+
+struct unix_time_stats_t
+{
+    /** Frequency correction applied to the local clock in ppm (Positive if the local clock runs slow) */
+    float frequency_ppm;
+    /** Phase error at the last measurement */
+    microseconds_t phase_error;
+    /** Phase correction yet to be slewed out */
+    microseconds_t slew_remaining;
+    /** Value of `time_us_64()` at the last accepted measurement */
+    uint64_t last_sync;
+    /** Number of measurements accepted by the loop */
+    uint32_t syncs;
+    /** Number of times the clock was stepped */
+    uint32_t steps;
+    /** Number of measurements rejected as outliers */
+    uint32_t rejections;
+    /** Clock has been synced since the last set_unix_time() */
+    bool synced;
+};
+
+/**
+ * Get clock discipline telemetry
+ */
+unix_time_stats_t get_unix_time_stats();
+
+/**
+ * Initializes internal lock
  */
 void init_unix_time();